@@ -0,0 +1,49 @@
+#include <fstream>
+#include "src/Benchmark.h"
+
+using namespace std;
+
+/*
+ * Usage: project_tsp_benchmark [--data=DIR] [--benchmark_repetitions=N] [--benchmark_filter=STR] [--benchmark_out=FILE]
+ *                              [--time_limit=SECONDS] [--threads=N] [--seed=N]
+ * Runs from the build directory like the menu, so the data directory defaults to ../src/data.
+ * Without a time limit the tours only depend on the seed and the number of threads (1 by default, 0 for one per core),
+ * so runs with the same values can be compared on any machine.
+ */
+int main(int argc, char *argv[]){
+    string dataDir = "../src/data";
+    string filter;
+    string out;
+    int repetitions = 5;
+    double timeLimit = 0;
+    unsigned threads = 1;
+    unsigned seed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string value = arg.substr(arg.find('=') + 1);
+        if (arg.rfind("--data=", 0) == 0) dataDir = value;
+        else if (arg.rfind("--benchmark_repetitions=", 0) == 0) repetitions = stoi(value);
+        else if (arg.rfind("--benchmark_filter=", 0) == 0) filter = value;
+        else if (arg.rfind("--benchmark_out=", 0) == 0) out = value;
+        else if (arg.rfind("--time_limit=", 0) == 0) timeLimit = stod(value);
+        else if (arg.rfind("--threads=", 0) == 0) threads = stoul(value);
+        else if (arg.rfind("--seed=", 0) == 0) seed = stoul(value);
+        else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    Benchmark benchmark(dataDir, repetitions, filter, timeLimit, threads, seed);
+    benchmark.run();
+    benchmark.printReport(cout);
+    benchmark.printInstrumentation(cout);
+
+    if (!out.empty()) {
+        ofstream file(out);
+        benchmark.writeCsv(file);
+    }
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include "src/Graph.h"
+#include "src/Random.h"
+
+using namespace std;
+
+/*
+ * Usage: project_tsp_precision_double|project_tsp_precision_float [--write=FILE] [--compare=FILE] [--bound=ERROR]
+ * Bounds the error that storing edge lengths and coordinates as float (TSP_FLOAT_WEIGHTS) adds to the tour lengths.
+ * The solvers run on generated graphs, so no data files are needed. A solver fails if the length it reports is more
+ * than the relative bound (1e-5 by default) away from the length of its tour summed in double from the exact distances.
+ * The same program is built with double and with float storage: the double build writes its tour lengths with --write
+ * and the float build fails if its own are further than the bound from them with --compare. Both run from ctest.
+ */
+
+namespace {
+    /// A generated graph, with the exact coordinates and edge lengths its vertexes and edges were built from.
+    struct Instance {
+        string name; /**< Name used in the report */
+        vector<double> latitude; /**< Exact latitude of each vertex */
+        vector<double> longitude; /**< Exact longitude of each vertex */
+        vector<map<int, double>> edges; /**< Exact length of the edges of each vertex, by neighbour */
+        bool complete; /**< Whether every pair of vertexes is joined by an edge */
+    };
+
+    /**
+     * Generates vertexes spread over a region the size of the real graphs, joined to every other vertex or only to
+     * their nearest ones, with the Haversine distance as edge length
+     * @param name - name of the graph
+     * @param n - number of vertexes
+     * @param neighbours - number of nearest vertexes each vertex is joined to, 0 for a complete graph
+     * @param seed - seed of the coordinates
+     * @return the generated graph
+     */
+    Instance generate(const string &name, int n, int neighbours, unsigned seed) {
+        Instance instance{name, vector<double>(n), vector<double>(n), vector<map<int, double>>(n), neighbours == 0};
+        mt19937 rng(seed);
+        for (int i = 0; i < n; i++) {
+            instance.latitude[i] = 37 + 5 * uniformReal(rng);
+            instance.longitude[i] = -9.5 + 3 * uniformReal(rng);
+        }
+
+        vector<pair<double, int>> near;
+        for (int i = 0; i < n; i++) {
+            near.clear();
+            for (int j = 0; j < n; j++) {
+                if (j != i) {
+                    near.emplace_back(DistanceOracle::haversine(instance.latitude[i], instance.longitude[i],
+                                                                instance.latitude[j], instance.longitude[j]), j);
+                }
+            }
+            size_t count = instance.complete ? near.size() : (size_t) neighbours;
+            partial_sort(near.begin(), near.begin() + (long) count, near.end());
+            for (size_t k = 0; k < count; k++) {
+                instance.edges[i][near[k].second] = near[k].first;
+                instance.edges[near[k].second][i] = near[k].first;
+            }
+        }
+        return instance;
+    }
+
+    /**
+     * Loads a generated graph like the scraper loads a real one
+     * @param instance - the generated graph
+     * @param graph - an empty graph, filled with the vertexes and edges
+     */
+    void build(const Instance &instance, Graph &graph) {
+        int n = (int) instance.latitude.size();
+        for (int i = 0; i < n; i++)
+            graph.addVertex(new Vertex(i, instance.longitude[i], instance.latitude[i]));
+        for (int i = 0; i < n; i++) {
+            for (auto &edge: instance.edges[i]) {
+                if (edge.first < i) continue;
+                Vertex *v1 = graph.findVertex(i), *v2 = graph.findVertex(edge.first);
+                graph.addBidirectionalEdge(v1, v2, edge.second);
+            }
+        }
+        graph.buildEdgeIndexes();
+    }
+
+    /**
+     * Sums the length of a tour in double from the exact edge lengths, or the exact Haversine distance where the graph
+     * has no edge
+     * @param instance - the generated graph
+     * @param path - the tour, starting and ending at the same vertex
+     * @return the exact length of the tour
+     */
+    double exactLength(const Instance &instance, const vInt &path) {
+        double length = 0;
+        for (size_t i = 0; i + 1 < path.size(); i++) {
+            int a = path[i], b = path[i + 1];
+            auto edge = instance.edges[a].find(b);
+            length += edge != instance.edges[a].end()
+                      ? edge->second
+                      : DistanceOracle::haversine(instance.latitude[a], instance.longitude[a],
+                                                  instance.latitude[b], instance.longitude[b]);
+        }
+        return length;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    string writeFile;
+    string compareFile;
+    double bound = 1e-5;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string value = arg.substr(arg.find('=') + 1);
+        if (arg.rfind("--write=", 0) == 0) writeFile = value;
+        else if (arg.rfind("--compare=", 0) == 0) compareFile = value;
+        else if (arg.rfind("--bound=", 0) == 0) bound = stod(value);
+        else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    map<string, double> reference;
+    if (!compareFile.empty()) {
+        ifstream in(compareFile);
+        if (!in) {
+            cerr << "Cannot read " << compareFile << endl;
+            return 1;
+        }
+        string name;
+        double length;
+        while (in >> name >> length)
+            reference[name] = length;
+    }
+    ofstream out;
+    if (!writeFile.empty()) out.open(writeFile);
+
+    cout << (sizeof(Scalar) == sizeof(float) ? "float" : "double") << " storage, relative bound " << bound << endl;
+    bool failed = false;
+    for (const Instance &instance: {generate("complete", 300, 0, 1), generate("sparse", 1000, 8, 2)}) {
+        Graph graph;
+        build(instance, graph);
+
+        vector<pair<string, function<double(vInt &)>>> solvers = {
+                {"nearestNeighbour", [&](vInt &path) { return graph.nearestNeighbourRouteTsp(path); }},
+                {"greedyEdge", [&](vInt &path) { return graph.greedyEdgeTsp(path); }},
+                {"twoOpt", [&](vInt &path) { return graph.twoOpt(path, graph.greedyEdgeTsp(path)); }},
+                {"iteratedLocalSearch", [&](vInt &path) {
+                    return graph.iteratedLocalSearch(path, graph.greedyEdgeTsp(path), SolveControl(), 1, 0);
+                }},
+        };
+        if (instance.complete)
+            solvers.emplace_back("christofides", [&](vInt &path) { return graph.christofides(path); });
+
+        for (auto &solver: solvers) {
+            string name = instance.name + "/" + solver.first;
+            vInt path(instance.latitude.size());
+            double reported = solver.second(path);
+            double exact = exactLength(instance, path);
+            double error = fabs(reported - exact) / exact;
+            bool passed = error <= bound;
+
+            cout << left << setw(32) << name << right << fixed << setprecision(3) << setw(16) << exact
+                 << scientific << setprecision(2) << setw(12) << error;
+            if (!compareFile.empty()) {
+                auto it = reference.find(name);
+                double difference = it == reference.end() ? INFINITY : fabs(exact - it->second) / it->second;
+                passed &= difference <= bound;
+                cout << setw(12) << difference;
+            }
+            cout << (passed ? "  ok" : "  FAILED") << endl;
+            failed |= !passed;
+
+            if (out.is_open()) out << name << " " << setprecision(17) << exact << "\n";
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+#include "src/Server.h"
+
+using namespace std;
+
+/*
+ * Usage: project_tsp_server [--threads=N]
+ * Reads requests from the standard input and writes the replies to the standard output, see Server.h for the
+ * protocol. File paths in load requests are relative to the directory the server runs from.
+ */
+int main(int argc, char *argv[]){
+    unsigned threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string value = arg.substr(arg.find('=') + 1);
+        if (arg.rfind("--threads=", 0) == 0) threads = stoul(value);
+        else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    Server server(threads);
+    server.run(cin, cout);
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// The replacements live in their own translation unit so that the compiler cannot inline them into a caller and
+// pair its new expression with the free below. C++14 has no aligned allocation functions to replace.
+
+namespace {
+    atomic<unsigned long long> heapAllocations(0); /**< Number of calls to the allocation functions */
+
+    /**
+     * Allocates and counts a block of memory
+     * @param size - size of the block, 0 is allocated as 1 byte so every allocation returns a distinct pointer
+     * @return the block, nullptr if it could not be allocated
+     */
+    void *allocate(size_t size) noexcept {
+        heapAllocations.fetch_add(1, memory_order_relaxed);
+        return malloc(size == 0 ? 1 : size);
+    }
+}
+
+unsigned long long AllocationCounter::allocations() {
+    return heapAllocations.load(memory_order_relaxed);
+}
+
+void *operator new(size_t size) {
+    void *p = allocate(size);
+    if (p == nullptr) throw bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) {
+    void *p = allocate(size);
+    if (p == nullptr) throw bad_alloc();
+    return p;
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept {
+    return allocate(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, const nothrow_t &) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, const nothrow_t &) noexcept {
+    free(p);
+}
@@ -0,0 +1,19 @@
+#ifndef PROJECT_TSP_ALLOCATIONCOUNTER_H
+#define PROJECT_TSP_ALLOCATIONCOUNTER_H
+
+/**
+ * Counts the heap allocations made through the global operator new. Only the benchmark links AllocationCounter.cpp,
+ * which replaces every replaceable global allocation and deallocation function, so the other programs keep the
+ * default ones.
+ */
+class AllocationCounter {
+public:
+    /**
+     * Gets the number of allocations made since the program started, by any thread
+     * Complexity: O(1)
+     * @return the number of calls to the allocation functions
+     */
+    static unsigned long long allocations();
+};
+
+#endif //PROJECT_TSP_ALLOCATIONCOUNTER_H
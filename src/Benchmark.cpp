@@ -0,0 +1,343 @@
+#include "Benchmark.h"
+#include "AllocationCounter.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace {
+    /// Names of the stages measured for each dataset, in the order they are run.
+    const vector<string> stages = {"load", "spatialRenumber", "mstBuild", "heldKarpBound", "tspBT", "triangularApproximation",
+                                   "nearestNeighbour", "metricClosure", "closureNearestNeighbour", "christofides", "hilbertCurve", "greedyEdge", "savings",
+                                   "cheapestInsertion", "farthestInsertion", "randomInsertion", "partitionMerge", "subsetTour",
+                                   "twoOpt", "parallelTwoOpt", "iteratedLocalSearch", "simulatedAnnealing", "geneticAlgorithm", "reoptimize"};
+}
+
+Benchmark::Benchmark(string dataDir, int repetitions, string filter, double timeLimit, unsigned threads, unsigned seed)
+        : dataDir(std::move(dataDir)), repetitions(max(repetitions, 1)), filter(std::move(filter)),
+          timeLimit(timeLimit), threads(threads == 0 ? max(1u, thread::hardware_concurrency()) : threads),
+          seed(seed) {}
+
+vector<Benchmark::Dataset> Benchmark::defaultDatasets() {
+    vector<Dataset> datasets = {
+            {"toy/shipping", "toy/shipping.csv", Scraper::toy, false},
+            {"toy/stadiums", "toy/stadiums.csv", Scraper::toy, true},
+            {"toy/tourism", "toy/tourism.csv", Scraper::toy, true},
+    };
+    for (int nodes: {25, 50, 75, 100, 200, 300, 400, 500, 600, 700, 800, 900}) {
+        datasets.push_back({"medium/edges_" + to_string(nodes), "medium/edges_" + to_string(nodes) + ".csv",
+                            Scraper::medium, true});
+    }
+    datasets.push_back({"real/graph1", "real/graph1/nodes.csv", Scraper::real, true});
+    datasets.push_back({"real/graph2", "real/graph2/nodes.csv", Scraper::real, false});
+    datasets.push_back({"real/graph3", "real/graph3/nodes.csv", Scraper::real, false});
+    return datasets;
+}
+
+SolveControl Benchmark::makeControl() const {
+    SolveControl control;
+    if (timeLimit > 0) control.setTimeLimit(timeLimit);
+    return control;
+}
+
+bool Benchmark::selected(const string &name) const {
+    return filter.empty() || name.find(filter) != string::npos;
+}
+
+void Benchmark::run() {
+    for (const Dataset &dataset: defaultDatasets()) {
+        bool anyStage = false;
+        for (const string &stage: stages) {
+            anyStage |= selected(dataset.name + "/" + stage);
+        }
+        if (!anyStage) continue;
+        if (!ifstream(dataDir + "/" + dataset.file).good()) {
+            cerr << "Skipping " << dataset.name << ": " << dataDir + "/" + dataset.file << " not found" << endl;
+            continue;
+        }
+        runDataset(dataset);
+    }
+}
+
+void Benchmark::runDataset(const Dataset &dataset) {
+    string file = dataDir + "/" + dataset.file;
+    string prefix = dataset.name + "/";
+    size_t firstResult = results.size();
+
+    // Every repetition scrapes into a fresh graph, the last one is kept for the algorithms
+    graph = nullptr;
+    if (selected(prefix + "load")) {
+        measure(prefix + "load", [&]() {
+            delete graph;
+            graph = new Graph();
+        }, [&]() {
+            Scraper::scrape_graph(file, *graph, dataset.type);
+            return 0.0;
+        });
+    }
+    if (graph == nullptr) {
+        graph = new Graph();
+        Scraper::scrape_graph(file, *graph, dataset.type);
+    }
+
+    // Real graphs are renumbered along the Hilbert curve once loaded, like in the menu
+    if (dataset.type == Scraper::real) {
+        if (selected(prefix + "spatialRenumber")) {
+            measure(prefix + "spatialRenumber", [] {}, [&]() {
+                graph->spatialRenumber();
+                return 0.0;
+            });
+        } else {
+            graph->spatialRenumber();
+        }
+    }
+
+    size_t size = graph->getVertexSet().size();
+    vInt path;
+    auto resetPath = [&]() { path = vInt(size); };
+
+    if (selected(prefix + "mstBuild")) {
+        measure(prefix + "mstBuild", [] {}, [&]() {
+            graph->mstBuild();
+            double weight = 0;
+            for (Vertex *v: graph->getVertexSet()) {
+                if (v->getPath() != nullptr) weight += v->getPath()->getDistance();
+            }
+            return weight;
+        });
+    }
+    // The bound is only valid for tours over the edges, so it is only computed on complete graphs
+    double lowerBound = 0;
+    if (dataset.complete && selected(prefix + "heldKarpBound")) {
+        double upperBound;
+        measure(prefix + "heldKarpBound", [&]() {
+            resetPath();
+            upperBound = graph->nearestNeighbourRouteTsp(path);
+        }, [&]() { return graph->heldKarpBound(upperBound); });
+        lowerBound = results.back().tourLength;
+    }
+    if (dataset.type == Scraper::toy && selected(prefix + "tspBT")) {
+        measure(prefix + "tspBT", resetPath, [&]() { return graph->tspBT(path, makeControl()); });
+    }
+    if (selected(prefix + "triangularApproximation")) {
+        measure(prefix + "triangularApproximation", resetPath,
+                [&]() { return graph->calculateTahTotalDistance(path); });
+    }
+    if (selected(prefix + "nearestNeighbour")) {
+        measure(prefix + "nearestNeighbour", resetPath, [&]() { return graph->nearestNeighbourRouteTsp(path); });
+    }
+    // Incomplete graphs are also measured over shortest path distances, every repetition starts with an empty cache
+    if (!dataset.complete) {
+        if (selected(prefix + "metricClosure")) {
+            measure(prefix + "metricClosure", [&]() { graph->setMetricClosure(true); }, [&]() {
+                graph->computeMetricClosure();
+                return 0.0;
+            });
+        }
+        if (selected(prefix + "closureNearestNeighbour")) {
+            measure(prefix + "closureNearestNeighbour", [&]() {
+                graph->setMetricClosure(true);
+                resetPath();
+            }, [&]() { return graph->nearestNeighbourRouteTsp(path); });
+        }
+        graph->setMetricClosure(false);
+    }
+    if (dataset.complete && selected(prefix + "christofides")) {
+        measure(prefix + "christofides", resetPath, [&]() { return graph->christofides(path); });
+    }
+    if (selected(prefix + "hilbertCurve")) {
+        measure(prefix + "hilbertCurve", resetPath, [&]() { return graph->hilbertCurveTsp(path); });
+    }
+    if (selected(prefix + "greedyEdge")) {
+        measure(prefix + "greedyEdge", resetPath, [&]() { return graph->greedyEdgeTsp(path); });
+    }
+    if (selected(prefix + "savings")) {
+        measure(prefix + "savings", resetPath, [&]() { return graph->savingsTsp(path); });
+    }
+    if (selected(prefix + "cheapestInsertion")) {
+        measure(prefix + "cheapestInsertion", resetPath,
+                [&]() { return graph->insertionTsp(path, Graph::cheapest_insertion); });
+    }
+    if (selected(prefix + "farthestInsertion")) {
+        measure(prefix + "farthestInsertion", resetPath,
+                [&]() { return graph->insertionTsp(path, Graph::farthest_insertion); });
+    }
+    if (selected(prefix + "randomInsertion")) {
+        measure(prefix + "randomInsertion", resetPath,
+                [&]() { return graph->insertionTsp(path, Graph::random_insertion, seed); });
+    }
+    if (dataset.type != Scraper::toy && selected(prefix + "partitionMerge")) {
+        measure(prefix + "partitionMerge", resetPath, [&]() { return graph->partitionTsp(path, makeControl(), threads); });
+    }
+    // A quarter of the vertexes, spread over the map since real graphs are renumbered along the Hilbert curve
+    if (dataset.type != Scraper::toy && selected(prefix + "subsetTour")) {
+        vInt ids;
+        for (int id = 0; id < size; id += 4) ids.push_back(id);
+        measure(prefix + "subsetTour", [] {}, [&]() { return graph->subsetTsp(ids, path, makeControl(), threads, seed); });
+    }
+    if (dataset.type != Scraper::toy && selected(prefix + "twoOpt")) {
+        double startDistance;
+        measure(prefix + "twoOpt", [&]() {
+            resetPath();
+            startDistance = graph->nearestNeighbourRouteTsp(path);
+        }, [&]() { return graph->twoOpt(path, startDistance, makeControl()); });
+    }
+    if (dataset.type != Scraper::toy && selected(prefix + "parallelTwoOpt")) {
+        double startDistance;
+        measure(prefix + "parallelTwoOpt", [&]() {
+            resetPath();
+            startDistance = graph->nearestNeighbourRouteTsp(path);
+        }, [&]() { return graph->parallelTwoOpt(path, startDistance, makeControl(), threads); });
+    }
+    if (dataset.type != Scraper::toy && selected(prefix + "iteratedLocalSearch")) {
+        double startDistance;
+        measure(prefix + "iteratedLocalSearch", [&]() {
+            resetPath();
+            startDistance = graph->nearestNeighbourRouteTsp(path);
+        }, [&]() { return graph->iteratedLocalSearch(path, startDistance, makeControl(), threads, seed); });
+    }
+    if (dataset.type != Scraper::toy && selected(prefix + "simulatedAnnealing")) {
+        double startDistance;
+        measure(prefix + "simulatedAnnealing", [&]() {
+            resetPath();
+            startDistance = graph->nearestNeighbourRouteTsp(path);
+        }, [&]() { return graph->simulatedAnnealing(path, startDistance, makeControl(), threads, seed); });
+    }
+    if (dataset.type != Scraper::toy && selected(prefix + "geneticAlgorithm")) {
+        double startDistance;
+        measure(prefix + "geneticAlgorithm", [&]() {
+            resetPath();
+            startDistance = graph->nearestNeighbourRouteTsp(path);
+        }, [&]() { return graph->geneticAlgorithm(path, startDistance, makeControl(), threads, seed); });
+    }
+    // Drops 1% of the stops of a greedy tour and adds them back, repairing the tour after each change
+    if (dataset.type != Scraper::toy && selected(prefix + "reoptimize")) {
+        Graph::TourDelta removal, insertion;
+        for (int id = size / 200; id < size; id += 100) removal.removed.push_back(max(id, 1));
+        insertion.inserted = removal.removed;
+        measure(prefix + "reoptimize", [&]() {
+            resetPath();
+            graph->greedyEdgeTsp(path);
+        }, [&]() {
+            graph->reoptimize(path, removal, makeControl());
+            return graph->reoptimize(path, insertion, makeControl());
+        });
+    }
+
+    if (lowerBound > 0) {
+        for (size_t r = firstResult; r < results.size(); r++) {
+            Result &result = results[r];
+            bool tour = result.name != prefix + "mstBuild" && result.name != prefix + "heldKarpBound";
+            if (tour && result.tourLength > 0) result.gap = (result.tourLength - lowerBound) / lowerBound * 100;
+        }
+    }
+
+    delete graph;
+    graph = nullptr;
+}
+
+void Benchmark::measure(const string &name, const function<void()> &setup, const function<double()> &body) {
+    Result result = {name, {}, 0, -1, -1, 0, ""};
+    unsigned long long allocations = 0;
+    DistanceOracle::Statistics cache;
+    for (int r = 0; r < repetitions; r++) {
+        setup();
+        // Every repetition starts with an empty distance cache, so repetitions take comparable times
+        if (graph != nullptr) {
+            graph->getDistanceOracle().clear();
+            graph->getDistanceOracle().resetStatistics();
+        }
+        // The instrumentation only covers the body, not the work done by the setup
+        Instrumentation::reset();
+        unsigned long long allocationsBefore = AllocationCounter::allocations();
+        auto start = chrono::high_resolution_clock::now();
+        result.tourLength = body();
+        auto finish = chrono::high_resolution_clock::now();
+        allocations += AllocationCounter::allocations() - allocationsBefore;
+        result.times.push_back(chrono::duration<double, milli>(finish - start).count());
+        if (graph != nullptr) {
+            DistanceOracle::Statistics stats = graph->getDistanceOracle().statistics();
+            cache.hits += stats.hits;
+            cache.misses += stats.misses;
+        }
+    }
+    if (cache.hits + cache.misses > 0) result.cacheHitRate = cache.hitRate();
+    result.allocations = (double) allocations / repetitions;
+    if (Instrumentation::enabled()) {
+        ostringstream report;
+        Instrumentation::report(report);
+        result.instrumentation = report.str();
+    }
+    results.push_back(result);
+}
+
+namespace {
+    /// Summary statistics of the repetitions of one benchmark, in milliseconds.
+    struct Statistics {
+        double mean, median, stddev, min, max;
+    };
+
+    Statistics computeStatistics(vector<double> times) {
+        Statistics stats = {0, 0, 0, 0, 0};
+        if (times.empty()) return stats;
+        sort(times.begin(), times.end());
+        for (double t: times) stats.mean += t;
+        stats.mean /= times.size();
+        for (double t: times) stats.stddev += (t - stats.mean) * (t - stats.mean);
+        stats.stddev = times.size() > 1 ? sqrt(stats.stddev / (times.size() - 1)) : 0;
+        size_t mid = times.size() / 2;
+        stats.median = times.size() % 2 == 1 ? times[mid] : (times[mid - 1] + times[mid]) / 2;
+        stats.min = times.front();
+        stats.max = times.back();
+        return stats;
+    }
+}
+
+void Benchmark::printReport(ostream &os) const {
+    const string line(152, '-');
+    os << "Seed " << seed << ", " << threads << (threads == 1 ? " thread" : " threads")
+       << (timeLimit > 0 ? ", time limited" : "") << endl
+       << line << endl
+       << left << setw(44) << "Benchmark" << right
+       << setw(15) << "Mean" << setw(15) << "Median" << setw(15) << "StdDev"
+       << setw(15) << "Min" << setw(6) << "Reps" << setw(14) << "Tour" << setw(8) << "Gap%" << setw(8) << "Hit%"
+       << setw(12) << "Allocs" << endl
+       << line << endl;
+
+    os << fixed << setprecision(3);
+    for (const Result &result: results) {
+        Statistics stats = computeStatistics(result.times);
+        os << left << setw(44) << result.name << right
+           << setw(12) << stats.mean << " ms" << setw(12) << stats.median << " ms" << setw(12) << stats.stddev
+           << " ms" << setw(12) << stats.min << " ms" << setw(6) << result.times.size();
+        if (result.tourLength > 0) os << setw(14) << setprecision(1) << result.tourLength << setprecision(3);
+        else os << setw(14) << "-";
+        if (result.gap >= 0) os << setw(8) << setprecision(2) << result.gap << setprecision(3);
+        else os << setw(8) << "-";
+        if (result.cacheHitRate >= 0) os << setw(8) << setprecision(1) << result.cacheHitRate * 100 << setprecision(3);
+        else os << setw(8) << "-";
+        os << setw(12) << setprecision(0) << result.allocations << setprecision(3) << endl;
+    }
+    os.unsetf(ios::floatfield);
+}
+
+void Benchmark::printInstrumentation(ostream &os) const {
+    for (const Result &result: results) {
+        if (result.instrumentation.empty()) continue;
+        os << endl << result.name << " (last of " << result.times.size() << " repetitions)" << endl
+           << result.instrumentation;
+    }
+}
+
+void Benchmark::writeCsv(ostream &os) const {
+    os << "name,repetitions,mean_ms,median_ms,stddev_ms,min_ms,max_ms,tour_length,gap_percent,cache_hit_rate,allocations" << endl;
+    os << fixed << setprecision(6);
+    for (const Result &result: results) {
+        Statistics stats = computeStatistics(result.times);
+        os << result.name << ',' << result.times.size() << ',' << stats.mean << ',' << stats.median << ','
+           << stats.stddev << ',' << stats.min << ',' << stats.max << ',' << result.tourLength << ','
+           << result.gap << ',' << result.cacheHitRate << ',' << result.allocations << endl;
+    }
+    os.unsetf(ios::floatfield);
+}
@@ -0,0 +1,121 @@
+#ifndef PROJECT_TSP_BENCHMARK_H
+#define PROJECT_TSP_BENCHMARK_H
+
+#include <iostream>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Scraper.h"
+
+using namespace std;
+
+class Benchmark {
+public:
+
+    /// Describes one of the graphs the benchmark can load.
+    struct Dataset {
+        string name; /**< Name used in the benchmark report, e.g. "real/graph1" */
+        string file; /**< Path of the file to be scraped, relative to the data directory */
+        Scraper::type_of_graph type; /**< Type of the graph */
+        bool complete; /**< Whether the graph is complete (Christofides is only run on complete graphs) */
+    };
+
+    /// Timings and tour lengths collected for one benchmark.
+    struct Result {
+        string name; /**< Name of the benchmark, in the format dataset/stage */
+        vector<double> times; /**< Wall time of each repetition, in milliseconds */
+        double tourLength; /**< Length of the tour (or tree) produced by the last repetition, 0 if not applicable */
+        double gap; /**< Percentage by which the tour exceeds the Held-Karp bound of the dataset, -1 if not computed */
+        double cacheHitRate; /**< Hit rate of the distance cache over all repetitions, -1 if it was not queried */
+        double allocations; /**< Mean number of heap allocations made by one repetition */
+        string instrumentation; /**< Stage times and counters of the last repetition, without its setup, empty if disabled */
+    };
+
+    /**
+     * Constructor for the Benchmark class
+     * @param dataDir - the directory that holds the toy, medium and real folders
+     * @param repetitions - number of times each benchmark is repeated
+     * @param filter - only benchmarks whose name contains this string are run (empty runs everything)
+     * @param timeLimit - time limit in seconds for the anytime solvers (tspBT, twoOpt and the metaheuristics), 0 for
+     * no limit
+     * @param threads - number of threads of the parallel solvers, 0 to use one per core
+     * @param seed - seed of the randomized solvers
+     */
+    Benchmark(string dataDir, int repetitions, string filter, double timeLimit = 0, unsigned threads = 1,
+              unsigned seed = 0);
+
+    /**
+     * Gets the list of graphs that are shipped with the project
+     * Complexity: O(1)
+     * @return the toy, medium and real datasets, in the same order as the menu
+     */
+    static vector<Dataset> defaultDatasets();
+
+    /**
+     * Runs every selected benchmark over every dataset found in the data directory
+     * Complexity: depends on the algorithms being measured
+     */
+    void run();
+
+    /**
+     * Prints a table with the statistics of every benchmark that was run
+     * Complexity: O(B*R*log(R)) where B is the number of benchmarks and R the number of repetitions
+     * @param os - the stream to print to
+     */
+    void printReport(ostream &os) const;
+
+    /**
+     * Prints the stage times and counters collected by the instrumentation layer for every benchmark that was run
+     * Complexity: O(B) where B is the number of benchmarks
+     * @param os - the stream to print to
+     */
+    void printInstrumentation(ostream &os) const;
+
+    /**
+     * Writes the statistics of every benchmark that was run in CSV format
+     * Complexity: O(B*R*log(R)) where B is the number of benchmarks and R the number of repetitions
+     * @param os - the stream to write to
+     */
+    void writeCsv(ostream &os) const;
+
+private:
+    string dataDir; /**< Directory that holds the datasets */
+    int repetitions; /**< Number of repetitions of each benchmark */
+    string filter; /**< Substring a benchmark name must contain to be run */
+    double timeLimit; /**< Time limit in seconds for the anytime solvers, 0 for no limit */
+    unsigned threads; /**< Number of threads of the parallel solvers, the number of chains and islands depends on it */
+    unsigned seed; /**< Seed of the randomized solvers */
+    vector<Result> results; /**< Results of the benchmarks that were run */
+    Graph *graph = nullptr; /**< Graph of the dataset being benchmarked */
+
+    /**
+     * Runs every selected benchmark over a single dataset
+     * @param dataset - the dataset to be benchmarked
+     */
+    void runDataset(const Dataset &dataset);
+
+    /**
+     * Creates the solve control passed to the anytime solvers, with the configured time limit
+     * @return a solve control whose deadline starts now
+     */
+    SolveControl makeControl() const;
+
+    /**
+     * Times a benchmark body over all repetitions and stores the result. The distance cache of the graph is cleared
+     * before each repetition and its hit rate is recorded, along with the heap allocations made by the body
+     * Complexity: O(R) calls to setup and body where R is the number of repetitions
+     * @param name - name of the benchmark
+     * @param setup - untimed function called before each repetition
+     * @param body - timed function, returns the tour length produced
+     */
+    void measure(const string &name, const function<void()> &setup, const function<double()> &body);
+
+    /**
+     * Checks if a benchmark should be run according to the filter
+     * @param name - name of the benchmark
+     * @return true if the benchmark is selected, false otherwise
+     */
+    bool selected(const string &name) const;
+};
+
+#endif //PROJECT_TSP_BENCHMARK_H
@@ -0,0 +1,75 @@
+#include "DistanceOracle.h"
+#include <cfloat>
+#include <cmath>
+#include <iomanip>
+
+DistanceOracle::DistanceOracle(size_t capacity, unsigned shards) : cache(capacity, shards) {}
+
+double DistanceOracle::distance(Vertex *v1, Vertex *v2) {
+    double dist;
+    if (closure == nullptr) {
+        Edge *e = v1->findEdge(v2->getId());
+        if (e != nullptr) return e->getDistance();
+    } else if (closure->cachedDistance(v1->getId(), v2->getId(), dist) && dist != DBL_MAX) {
+        // A cached row already holds the distance, copying it into the pair cache would only evict other pairs
+        return dist;
+    }
+
+    // Distances are symmetric, so both orders of a pair share one entry
+    unsigned a = min(v1->getId(), v2->getId()), b = max(v1->getId(), v2->getId());
+    unsigned long long key = (unsigned long long) a << 32 | b;
+    if (cache.get(key, dist)) return dist;
+
+    dist = closure != nullptr ? closure->distance(v1->getId(), v2->getId()) : DBL_MAX;
+    if (dist == DBL_MAX)
+        dist = haversine(v1->getLatitude(), v1->getLongitude(), v2->getLatitude(), v2->getLongitude());
+    cache.put(key, dist);
+    return dist;
+}
+
+void DistanceOracle::setMetricClosure(shared_ptr<MetricClosure> closure) {
+    this->closure = std::move(closure);
+    cache.clear();
+}
+
+void DistanceOracle::clear() {
+    cache.clear();
+}
+
+DistanceOracle::Statistics DistanceOracle::statistics() const {
+    return cache.statistics();
+}
+
+void DistanceOracle::resetStatistics() {
+    cache.resetStatistics();
+}
+
+void DistanceOracle::report(ostream &os) const {
+    Statistics stats = statistics();
+    os << "Distance cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+       << fixed << setprecision(1) << stats.hitRate() * 100 << "% hit rate), " << stats.evictions << " evictions, "
+       << stats.size << "/" << cache.capacity() << " pairs" << endl;
+    os.unsetf(ios::floatfield);
+}
+
+namespace {
+    double convert_to_radians(double coordinate) {
+        return coordinate * M_PI / 180;
+    }
+}
+
+double DistanceOracle::haversine(double lat1, double long1, double lat2, double long2) {
+    INSTRUMENT_COUNT(haversineEvaluations);
+    lat1 = convert_to_radians(lat1);
+    lat2 = convert_to_radians(lat2);
+    long1 = convert_to_radians(long1);
+    long2 = convert_to_radians(long2);
+
+    double delta_lat = lat2 - lat1;
+    double delta_long = long2 - long1;
+
+    double aux = pow(sin(delta_lat / 2), 2) + cos(lat1) * cos(lat2) * pow(sin(delta_long / 2), 2);
+    double c = 2.0 * atan2(sqrt(aux), sqrt(1 - aux));
+    double earth_radius = 6371000.0;
+    return earth_radius * c;
+}
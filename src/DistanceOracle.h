@@ -0,0 +1,91 @@
+#ifndef PROJECT_TSP_DISTANCEORACLE_H
+#define PROJECT_TSP_DISTANCEORACLE_H
+
+#include <iostream>
+#include <memory>
+#include "VertexEdge.h"
+#include "MetricClosure.h"
+#include "ShardedLruCache.h"
+
+using namespace std;
+
+/**
+ * Answers distance queries between two vertexes of a graph. The length of the edge between them is used when there
+ * is one. Otherwise, the distance is computed (straight line Haversine distance or, with a metric closure, shortest
+ * path distance) and kept in a bounded, sharded LRU cache, so repeated queries for the same pair, as done by the
+ * tour improvement algorithms, are answered without computing it again and without a V*V matrix in memory. With a
+ * metric closure, pairs whose shortest path row is already cached are read from the row and skip the pair cache.
+ */
+class DistanceOracle {
+public:
+    typedef ShardedLruCache<unsigned long long, double>::Statistics Statistics;
+
+    static const size_t defaultCapacity = 1 << 19; /**< Default number of cached pairs, around 50 MB */
+
+    /**
+     * Constructor for the DistanceOracle class
+     * @param capacity - maximum number of vertex pairs kept in the cache
+     * @param shards - number of shards of the cache, each one with its own lock
+     */
+    explicit DistanceOracle(size_t capacity = defaultCapacity, unsigned shards = 16);
+
+    /**
+     * Gets the distance between two vertexes
+     * Complexity: O(E) where E is the number of edges of v1 to look for an edge, or O(1) with a metric closure and a
+     * cached row of either vertex, then O(1) on average on a cache hit
+     * @param v1 - the first vertex
+     * @param v2 - the second vertex
+     * @return the length of the edge between the vertexes if there is one (and there is no metric closure), otherwise
+     * the shortest path distance if there is a metric closure and a path, otherwise the Haversine distance
+     */
+    double distance(Vertex *v1, Vertex *v2);
+
+    /**
+     * Sets the metric closure used for the pairs without an edge, or removes it, and clears the cache. With a metric
+     * closure, edges are not used directly, since a path through other vertexes may be shorter
+     * Must not be called while other threads are querying the oracle
+     * @param closure - the metric closure, nullptr to use the Haversine distance
+     */
+    void setMetricClosure(shared_ptr<MetricClosure> closure);
+
+    /**
+     * Removes every cached distance. Must be called when the vertexes are renumbered
+     * Complexity: O(N) where N is the number of cached pairs
+     */
+    void clear();
+
+    /**
+     * Gets the number of hits, misses and evictions of the cache and the number of cached pairs. Queries answered by
+     * an edge or by a cached row of the metric closure do not count as hits or misses
+     * @return the statistics of the cache
+     */
+    Statistics statistics() const;
+
+    /**
+     * Sets the hit, miss and eviction counters back to zero
+     */
+    void resetStatistics();
+
+    /**
+     * Prints the hit rate and counters of the cache
+     * @param os - the stream to print to
+     */
+    void report(ostream &os) const;
+
+    /**
+     * Computes the distance between two points using the haversine formula
+     * Complexity: O(1)
+     * @param lat1 - latitude of the first point
+     * @param long1 - longitude of the first point
+     * @param lat2 - latitude of the second point
+     * @param long2 - longitude of the second point
+     * @return distance between the two points in meters
+     */
+    static double haversine(double lat1, double long1, double lat2, double long2);
+
+private:
+    ShardedLruCache<unsigned long long, double> cache; /**< Distances of the pairs without an edge */
+    shared_ptr<MetricClosure> closure; /**< Shortest path distances, nullptr to use the Haversine distance */
+};
+
+#endif //PROJECT_TSP_DISTANCEORACLE_H
@@ -1,56 +1,112 @@
 #include "Graph.h"
-
-std::unordered_map<int, Vertex *> Graph::getVertexSet() const {
+#include "LocalSearch.h"
+#include "TourDistance.h"
+#include "ParallelSort.h"
+#include "Random.h"
+#include "TwoLevelList.h"
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+const std::vector<Vertex *> &Graph::getVertexSet() const {
     return vertexSet;
 }
 
 Vertex *Graph::findVertex(const int &id) const {
-    auto v = vertexSet.find(id);
-    if (v == vertexSet.end()) return nullptr;
-    else return v->second;
+    if (id < 0 || id >= vertexSet.size()) return nullptr;
+    return vertexSet[id];
+}
+
+Vertex *Graph::findVertexByOriginalId(int originalId) const {
+    auto id = denseIds.find(originalId);
+    if (id == denseIds.end()) return nullptr;
+    return vertexSet[id->second];
+}
+
+int Graph::getOriginalId(int id) const {
+    return originalIds[id];
 }
 
 bool Graph::addVertex(Vertex *v) {
-    if (findVertex(v->getId()) != nullptr)
+    int originalId = v->getId();
+    if (denseIds.count(originalId))
         return false;
-    vertexSet.insert({v->getId(), v});
+
+    int id = (int) vertexSet.size();
+    v->setId(id);
+    vertexSet.push_back(v);
+    originalIds.push_back(originalId);
+    denseIds[originalId] = id;
+
+    // Tours start at vertex 0, so the vertex with input id 0 always takes the dense id 0
+    if (originalId == 0 && id != 0) {
+        swap(vertexSet[0], vertexSet[id]);
+        swap(originalIds[0], originalIds[id]);
+        vertexSet[0]->setId(0);
+        vertexSet[id]->setId(id);
+        denseIds[originalIds[0]] = 0;
+        denseIds[originalIds[id]] = id;
+    }
     return true;
 }
 
 Graph::~Graph() {
+    for (Vertex *v: vertexSet) {
+        delete v;
+    }
 }
 
 bool Graph::addBidirectionalEdge(Vertex *&v1, Vertex *&v2, double dist) {
     if (v1 == nullptr || v2 == nullptr) return false;
-    auto e1 = v1->addEdge(v2, dist);
-    auto e2 = v2->addEdge(v1, dist);
-    e1->setReverse(e2);
-    e2->setReverse(e1);
+    edgeSet.emplace_back(v1, v2, dist);
+    v1->addEdge(&edgeSet.back());
+    v2->addEdge(&edgeSet.back());
+    return true;
+}
+
+bool Graph::setEdgeDistance(Vertex *v1, Vertex *v2, double dist) {
+    Edge *e = v1->findEdge(v2->getId());
+    if (e == nullptr) return false;
+    double oldDist = e->getDistance();
+    e->setDistance(dist);
+
+    // Only the rows with a shortest path through the edge change. The cached pairs do not say which row they came
+    // from, so they are all dropped
+    if (closure != nullptr) {
+        closure->updateEdge(v1->getId(), v2->getId(), oldDist, e->getDistance());
+        oracle->clear();
+    }
     return true;
 }
 
-void Graph::mstBuild() {
+void Graph::mstBuild(const vector<double> &penalties, Vertex *excluded) {
+    INSTRUMENT_SCOPE("mstBuild");
     if (vertexSet.empty()) {
         return;
     }
 
     MutablePriorityQueue<Vertex> q;
 
-    for (auto v: vertexSet) {
-        v.second->setPath(nullptr);
-        v.second->setPrimDist(DBL_MAX);
-        v.second->setVisited(false);
-        q.insert(v.second);
-        v.second->setOutdegree(0);
-        for (Edge *e: v.second->getAdj()) {
-            e->setSelected(false);
-            e->getReverse()->setSelected(false);
-            e->setIsDouble(false);
-            e->getReverse()->setIsDouble(false);
-        }
+    for (Vertex *v: vertexSet) {
+        v->setPath(nullptr);
+        v->setPrimDist(DBL_MAX);
+        v->setVisited(v == excluded);
+        if (v != excluded) q.insert(v);
+        v->setOutdegree(0);
+    }
+    for (Edge &e: edgeSet) {
+        e.setSelected(false);
+        e.setIsDouble(false);
+    }
+    if (q.empty()) {
+        return;
     }
 
-    auto s = this->findVertex(0);
+    auto s = excluded == vertexSet[0] ? vertexSet[1] : vertexSet[0];
     s->setPrimDist(0);
     q.decreaseKey(s);
 
@@ -58,29 +114,101 @@ void Graph::mstBuild() {
         auto v = q.extractMin();
         v->setVisited(true);
         for (auto &e: v->getAdj()) {
-            auto w = e->getDest();
-            if (!w->isVisited() && e->getDistance() < w->getPrimDist()) {
+            auto w = e->getOther(v);
+            double dist = e->getDistance();
+            if (!penalties.empty()) dist += penalties[v->getId()] + penalties[w->getId()];
+            if (!w->isVisited() && dist < w->getPrimDist()) {
                 Edge *prevPath = w->getPath();
-                if (prevPath != nullptr) {
-                    prevPath->setSelected(false);
-                    prevPath->getReverse()->setSelected(false);
-                }
+                if (prevPath != nullptr) prevPath->setSelected(false);
 
-                w->setPrimDist(e->getDistance());
+                w->setPrimDist(dist);
                 w->setPath(e);
                 q.decreaseKey(w);
                 e->setSelected(true);
-                e->getReverse()->setSelected(true);
             }
         }
     }
 }
 
+double Graph::heldKarpBound(double upperBound, int iterations, const SolveControl &control) {
+    INSTRUMENT_SCOPE("heldKarpBound");
+    auto n = vertexSet.size();
+    if (n < 3) return upperBound;
+
+    // The 1-tree is a spanning tree of every vertex but the first one, plus the two shortest edges of the first one
+    Vertex *special = vertexSet[0];
+    vector<double> penalties(n, 0);
+    vInt degree(n);
+    double best = 0;
+    double step = 2;
+    int sinceImprovement = 0;
+
+    for (int it = 0; it < iterations && !control.shouldStop(); it++) {
+        mstBuild(penalties, special);
+
+        double bound = 0;
+        fill(degree.begin(), degree.end(), 0);
+        bool spanning = true;
+        for (Vertex *v: vertexSet) {
+            if (v == special) continue;
+            Edge *e = v->getPath();
+            if (e == nullptr) {
+                if (v->getPrimDist() != 0) spanning = false;
+                continue;
+            }
+            bound += v->getPrimDist();
+            degree[e->getOther(v)->getId()]++;
+            degree[v->getId()]++;
+        }
+
+        double first = DBL_MAX, second = DBL_MAX;
+        int firstId = -1, secondId = -1;
+        for (Edge *e: special->getAdj()) {
+            int id = e->getOther(special)->getId();
+            double dist = e->getDistance() + penalties[special->getId()] + penalties[id];
+            if (dist < first) {
+                second = first;
+                secondId = firstId;
+                first = dist;
+                firstId = id;
+            } else if (dist < second) {
+                second = dist;
+                secondId = id;
+            }
+        }
+        // Without a spanning 1-tree there is no tour over the edges, and no bound
+        if (!spanning || secondId == -1) return 0;
+        bound += first + second;
+        degree[special->getId()] = 2;
+        degree[firstId]++;
+        degree[secondId]++;
+
+        for (double p: penalties) bound -= 2 * p;
+        if (bound > best + 1e-9) {
+            best = bound;
+            sinceImprovement = 0;
+        } else if (++sinceImprovement == 10) {
+            step /= 2;
+            sinceImprovement = 0;
+        }
+
+        // Subgradient step: vertexes with degree above 2 get more expensive, leaves get cheaper
+        double norm = 0;
+        for (int d: degree) norm += (d - 2) * (d - 2);
+        if (norm == 0) break; // the 1-tree is a tour, so it is optimal
+        double t = step * max(upperBound - bound, 1e-9 * upperBound) / norm;
+        for (int id = 0; id < n; id++)
+            penalties[id] += t * (degree[id] - 2);
+    }
+
+    return best;
+}
+
 void Graph::dfsMst(Vertex *v, vInt &path, int &count) {
     v->setVisited(true);
     path[count++] = v->getId();
     for (auto &e: v->getAdj()) {
-        auto w = e->getDest();
+        auto w = e->getOther(v);
         if (!w->isVisited() && e == w->getPath()) {
             dfsMst(w, path, count);
         }
@@ -88,14 +216,15 @@ void Graph::dfsMst(Vertex *v, vInt &path, int &count) {
 }
 
 double Graph::calculateTahTotalDistance(vInt &path) {
+    INSTRUMENT_SCOPE("calculateTahTotalDistance");
     double totalDistance = 0;
     auto s = this->findVertex(0);
     int count = 0;
 
     mstBuild();
 
-    for (auto v: vertexSet) {
-        v.second->setVisited(false);
+    for (Vertex *v: vertexSet) {
+        v->setVisited(false);
     }
 
     dfsMst(s, path, count);
@@ -103,79 +232,70 @@ double Graph::calculateTahTotalDistance(vInt &path) {
     path.push_back(0);
 
     for (auto i = 0; i < path.size() - 1; i++) {
-        auto v = findVertex(path[i]);
-        auto w = findVertex(path[i + 1]);
-        auto e = v->findEdge(w->getId());
-        if (e == nullptr) {
-            totalDistance += haversineCalculator(v->getLatitude(), v->getLongitude(), w->getLatitude(),
-                                                 w->getLongitude());
-        } else {
-            totalDistance += e->getDistance();
-        }
+        totalDistance += calculateTwoVerticesDist(findVertex(path[i]), findVertex(path[i + 1]));
     }
 
     return totalDistance;
 }
 
-double convert_to_radians(double coordinate) {
-    return coordinate * M_PI / 180;
-}
-
 double Graph::haversineCalculator(double lat1, double long1, double lat2, double long2) {
-    lat1 = convert_to_radians(lat1);
-    lat2 = convert_to_radians(lat2);
-    long1 = convert_to_radians(long1);
-    long2 = convert_to_radians(long2);
-
-    double delta_lat = lat2 - lat1;
-    double delta_long = long2 - long1;
-
-    double aux = pow(sin(delta_lat / 2), 2) + cos(lat1) * cos(lat2) * pow(sin(delta_long / 2), 2);
-    double c = 2.0 * atan2(sqrt(aux), sqrt(1 - aux));
-    double earth_radius = 6371000.0;
-    return earth_radius * c;
+    return DistanceOracle::haversine(lat1, long1, lat2, long2);
 }
 
 
-double Graph::tspBT(vInt &path) {
-    for (auto v: vertexSet) {
-        v.second->setVisited(false);
+double Graph::tspBT(vInt &path, const SolveControl &control) {
+    INSTRUMENT_SCOPE("tspBT");
+    for (Vertex *v: vertexSet) {
+        v->setVisited(false);
     }
 
     findVertex(0)->setVisited(true);
     path[0] = 0;
 
-    double bestDist = tspBacktracking(path, 0, 0, DBL_MAX, 1);
+    double bestDist = tspBacktracking(path, 0, 0, DBL_MAX, 1, control);
     path.push_back(0);
     return bestDist;
 
 }
 
-double Graph::tspBacktracking(vInt &path, int currVertexId, double currSum, double bestSum, uint step) {
+double Graph::tspBacktracking(vInt &path, int currVertexId, double currSum, double bestSum, uint step,
+                              const SolveControl &control) {
     double thisSum = 0;
     Vertex *currVertex = findVertex(currVertexId);
 
+    if (control.shouldStop())
+        return bestSum;
+
     if (step == vertexSet.size()) {
+        if (closure != nullptr) return currSum + calculateTwoVerticesDist(currVertex, findVertex(0));
         Edge *e = currVertex->findEdge(0);
         return e != nullptr ? currSum + e->getDistance() : bestSum;
     }
 
-    for (auto v: vertexSet) {
-        Vertex *destVertex = v.second;
+    for (Vertex *v: vertexSet) {
+        Vertex *destVertex = v;
 
         if (destVertex->isVisited())
             continue;
 
-        Edge *e = currVertex->findEdge(v.first);
-        if (e == nullptr) continue;
-        double dist = e->getDistance();
+        double dist;
+        if (closure != nullptr) {
+            dist = calculateTwoVerticesDist(currVertex, destVertex);
+        } else {
+            Edge *e = currVertex->findEdge(v->getId());
+            if (e == nullptr) continue;
+            dist = e->getDistance();
+        }
 
         if (currSum + dist < bestSum) {
             destVertex->setVisited(true);
-            thisSum = tspBacktracking(path, v.first, currSum + dist, bestSum, step + 1);
+            thisSum = tspBacktracking(path, v->getId(), currSum + dist, bestSum, step + 1, control);
             if (thisSum < bestSum) {
                 bestSum = thisSum;
-                path[step] = v.first;
+                path[step] = v->getId();
+                // bestSum always holds the global best, so a complete tour beating it is a new best tour
+                if (step == vertexSet.size() - 1)
+                    control.reportProgress(bestSum);
             }
             destVertex->setVisited(false);
         }
@@ -184,82 +304,144 @@ double Graph::tspBacktracking(vInt &path, int currVertexId, double currSum, doub
     return bestSum;
 }
 
+namespace {
+    const size_t maxMatrixCities = 4096; /**< Largest number of cities whose edge lengths are copied into a matrix */
+
+    /**
+     * Runs a solver kernel with the fastest distance policy the graph allows. The kernel is a generic lambda, so it is
+     * compiled once per policy and the policy is chosen once per call: complete graphs read a matrix of edge lengths,
+     * graphs whose metric closure already holds every row read those rows, and the other graphs ask the distance
+     * oracle, which computes the closure rows on demand or falls back to the Haversine distance for missing edges.
+     * The closure is never computed here, see computeMetricClosure
+     * Complexity: O(n^2) to fill the matrix of a complete graph, plus the complexity of the kernel
+     * @param graph - the graph the cities belong to
+     * @param cities - the cities, the kernel identifies them by their index in this vector
+     * @param kernel - called with the distance functor
+     * @return the value returned by the kernel
+     */
+    template<class Kernel>
+    double withDistancePolicy(Graph &graph, const vector<Vertex *> &cities, Kernel kernel) {
+        if (graph.usesMetricClosure()) {
+            if (graph.getMetricClosure()->cachedRows() >= graph.getVertexSet().size())
+                return kernel(ClosureDistance(graph, cities));
+        } else if (cities.size() <= maxMatrixCities && graph.isComplete()) {
+            return kernel(CompleteDistance(cities));
+        }
+        return kernel(GraphDistance(graph, cities));
+    }
+}
+
 vector<Vertex *> Graph::findOddDegreeVertexes() {
+    INSTRUMENT_SCOPE("findOddDegreeVertexes");
     vector<Vertex *> oddDegreeVertices;
     int outdegree;
 
-    for (auto v: vertexSet) {
+    for (Vertex *v: vertexSet) {
         outdegree = 0;
-        for (Edge *e: v.second->getAdj()) {
+        for (Edge *e: v->getAdj()) {
             if (e->getSelected())
                 outdegree++;
         }
         if (outdegree % 2 == 1)
-            oddDegreeVertices.push_back(v.second);
+            oddDegreeVertices.push_back(v);
 
-        v.second->setOutdegree(outdegree);
+        v->setOutdegree(outdegree);
     }
 
     return oddDegreeVertices;
 }
 
 void Graph::greedyPerfectMatching(vector<Vertex *> &oddDegreeVertexes) {
-    Vertex *curr;
-    double minDist;
-    Edge *toAdd;
-    vector<Vertex *>::iterator toRemove;
-
-    while (!oddDegreeVertexes.empty()) {
-        curr = oddDegreeVertexes.back();
-        oddDegreeVertexes.pop_back();
-        toAdd = nullptr;
-        minDist = DBL_MAX;
-
-        for (auto itr = oddDegreeVertexes.begin(); itr != oddDegreeVertexes.end(); itr++) {
-            Edge *e = curr->findEdge((*itr)->getId());
-
-            if (e->getDistance() < minDist) {
-                minDist = e->getDistance();
-                toAdd = e;
-                toRemove = itr;
+    INSTRUMENT_SCOPE("greedyPerfectMatching");
+    // The vertexes are matched by their index in this copy, only the chosen edges are looked up
+    const vector<Vertex *> cities = oddDegreeVertexes;
+    oddDegreeVertexes.clear();
+
+    withDistancePolicy(*this, cities, [&](const auto &dist) {
+        vInt unmatched(cities.size());
+        iota(unmatched.begin(), unmatched.end(), 0);
+        double matchingDistance = 0;
+
+        while (!unmatched.empty()) {
+            int curr = unmatched.back();
+            unmatched.pop_back();
+            double minDist = DBL_MAX;
+            size_t toRemove = 0;
+
+            for (size_t i = 0; i < unmatched.size(); i++) {
+                double distance = dist(curr, unmatched[i]);
+                if (distance < minDist) {
+                    minDist = distance;
+                    toRemove = i;
+                }
             }
-        }
 
-        if (toAdd->getSelected()) {
-            toAdd->setIsDouble(true);
-            toAdd->getReverse()->setIsDouble(true);
-            toAdd->getOrig()->setOutdegree(toAdd->getOrig()->getOutdegree() + 1);
-            toAdd->getDest()->setOutdegree(toAdd->getDest()->getOutdegree() + 1);
-        }
-        else {
-            toAdd->setSelected(true);
-            toAdd->getReverse()->setSelected(true);
+            Edge *toAdd = cities[curr]->findEdge(cities[unmatched[toRemove]]->getId());
+            if (toAdd->getSelected())
+                toAdd->setIsDouble(true);
+            else
+                toAdd->setSelected(true);
             toAdd->getOrig()->setOutdegree(toAdd->getOrig()->getOutdegree() + 1);
             toAdd->getDest()->setOutdegree(toAdd->getDest()->getOutdegree() + 1);
-        }
 
-        oddDegreeVertexes.erase(toRemove);
-    }
+            matchingDistance += minDist;
+            unmatched.erase(unmatched.begin() + (long) toRemove);
+        }
+        return matchingDistance;
+    });
 }
 
 double Graph::nearestNeighbourRouteTsp(vInt &path) {
-    for (auto v: vertexSet) {
-        v.second->setVisited(false);
+    INSTRUMENT_SCOPE("nearestNeighbourRouteTsp");
+    for (Vertex *v: vertexSet) {
+        v->setVisited(false);
     }
 
     Vertex *currVertex = findVertex(0);
     path[0] = 0;
-    Vertex *nextVertex;
+    Vertex *nextVertex = currVertex;
     currVertex->setVisited(true);
     double totalDistance = 0;
     int numVisited = 1;
 
+    // Every vertex is a candidate in the metric closure mode, so the scan runs on the rows of the closure instead of
+    // the adjacency list. A single pass over a complete graph is cheaper on its adjacency than filling a matrix
+    if (closure != nullptr) {
+        return withDistancePolicy(*this, vertexSet, [&](const auto &dist) {
+            vector<char> visited(vertexSet.size(), 0);
+            visited[0] = 1;
+            int curr = 0;
+            double distance = 0;
+
+            for (size_t step = 1; step < vertexSet.size(); step++) {
+                double minDistance = DBL_MAX;
+                int next = curr;
+                for (int v = 0; v < (int) vertexSet.size(); v++) {
+                    if (visited[v]) continue;
+                    double d = dist(curr, v);
+                    if (d < minDistance || next == curr) {
+                        minDistance = d;
+                        next = v;
+                    }
+                }
+                distance += minDistance;
+                path[step] = next;
+                visited[next] = 1;
+                curr = next;
+            }
+
+            distance += dist(curr, 0);
+            path.push_back(0);
+            return distance;
+        });
+    }
+
     while (numVisited < vertexSet.size()) {
         double minDistance = DBL_MAX;
         for (auto e: currVertex->getAdj()) {
-            if (e->getDistance() < minDistance && !e->getDest()->isVisited()) {
+            if (e->getDistance() < minDistance && !e->getOther(currVertex)->isVisited()) {
                 minDistance = e->getDistance();
-                nextVertex = e->getDest();
+                nextVertex = e->getOther(currVertex);
             }
         }
 
@@ -275,7 +457,7 @@ double Graph::nearestNeighbourRouteTsp(vInt &path) {
         currVertex = nextVertex;
     }
 
-    totalDistance += currVertex->findEdge(0) == nullptr ? haversineCalculator(currVertex->getLatitude(),currVertex->getLongitude(),findVertex(0)->getLatitude(),findVertex(0)->getLongitude()): currVertex->findEdge(0)->getDistance();
+    totalDistance += calculateTwoVerticesDist(currVertex, findVertex(0));
     path.push_back(0);
 
     return totalDistance;
@@ -284,65 +466,76 @@ double Graph::nearestNeighbourRouteTsp(vInt &path) {
 Vertex *Graph::findNearestHaversine(Vertex *currentV) {
     auto minDistance = DBL_MAX;
     Vertex *nearestV;
-    for (auto v: vertexSet) {
-        if (currentV->findEdge(v.second->getId()) || v.second->isVisited()) {
+    for (Vertex *v: vertexSet) {
+        if (currentV->findEdge(v->getId()) || v->isVisited()) {
             continue;
         }
-        double distance = haversineCalculator(currentV->getLatitude(), currentV->getLongitude(),v.second->getLatitude(), v.second->getLongitude());
+        double distance = haversineCalculator(currentV->getLatitude(), currentV->getLongitude(),v->getLatitude(), v->getLongitude());
         if (distance < minDistance) {
             minDistance = distance;
-            nearestV = v.second;
+            nearestV = v;
         }
     }
 
     return nearestV;
 }
 
-double Graph::twoOpt(vInt &path, double bestDistance) {
-    double newDistance = bestDistance;
-    auto size = path.size();
-    bool improved = true;
-
-    while (improved) {
-        improved = false;
-        for (int i = 1; i < size - 2; i++) {
-            for (int k = i + 1; k < size - 1; k++) {
-                int delta = -calculateTwoVerticesDist(findVertex(path[i]), findVertex(path[i + 1])) -
-                            calculateTwoVerticesDist(findVertex(path[k]), findVertex(path[k + 1])) +
-                            calculateTwoVerticesDist(findVertex(path[i]), findVertex(path[k])) +
-                            calculateTwoVerticesDist(findVertex(path[i + 1]), findVertex(path[k + 1]));
-                if (delta < 0) {
-                    path = twoOptSwap(path, i, k);
-                    bestDistance += delta;
-                    improved = true;
+double Graph::twoOpt(vInt &path, double bestDistance, const SolveControl &control) {
+    INSTRUMENT_SCOPE("twoOpt");
+    if (path.size() < 4) return bestDistance;
+
+    // a and c walk the tour like the positions i < k of the path, the first vertex never moves
+    int start = path.front();
+    TwoLevelList tour(vInt(path.begin(), path.end() - 1));
+
+    // The cities are the whole vertex set, so the index of a city is its vertex id
+    bestDistance = withDistancePolicy(*this, vertexSet, [&](const auto &dist) {
+        double distance = bestDistance;
+        bool improved = true;
+
+        while (improved && !control.shouldStop()) {
+            improved = false;
+            for (int a = tour.next(start); tour.next(a) != start; a = tour.next(a)) {
+                if (control.shouldStop())
+                    break;
+                for (int c = tour.next(a); c != start; c = tour.next(c)) {
+                    int b = tour.next(a), d = tour.next(c);
+                    double delta = dist(a, c) + dist(b, d) - dist(a, b) - dist(c, d);
+                    INSTRUMENT_COUNT(twoOptMovesEvaluated);
+                    if (delta < -improvementEpsilon) {
+                        INSTRUMENT_COUNT(twoOptMovesAccepted);
+                        tour.flip(b, c);
+                        c = b;
+                        distance += delta;
+                        improved = true;
+                    }
                 }
             }
+            if (improved)
+                control.reportProgress(distance);
         }
-    }
+        return distance;
+    });
 
+    tour.copyTo(path, start);
+    path.push_back(start);
     return bestDistance;
 }
 
 double Graph::calculateTwoVerticesDist(Vertex *v1, Vertex *v2) {
-    Edge *e = v1->findEdge(v2->getId());
-    return e == nullptr ? haversineCalculator(v1->getLatitude(), v1->getLongitude(),v2->getLatitude(), v2->getLongitude()): e->getDistance();
+    return oracle->distance(v1, v2);
 }
 
-vInt Graph::twoOptSwap(vInt path, int i, int k) {
-    vInt newPath;
-    for (int j = 0; j <= i; j++) {
-        newPath.push_back(path[j]);
-    }
-    for (int j = k; j > i; j--) {
-        newPath.push_back(path[j]);
-    }
-    for (int j = k + 1; j < path.size(); j++) {
-        newPath.push_back(path[j]);
-    }
-    return newPath;
+DistanceOracle &Graph::getDistanceOracle() const {
+    return *oracle;
+}
+
+void Graph::twoOptSwap(vInt &path, int i, int k) {
+    reverse(path.begin() + i + 1, path.begin() + k + 1);
 }
 
 vector<Vertex *> Graph::buildEulerianTour() {
+    INSTRUMENT_SCOPE("buildEulerianTour");
     vector<Vertex *> eulerianTour;
     vector<vector<Vertex *>> eulerianPaths;
     vector<Vertex *> oneEulerianPath;
@@ -364,7 +557,7 @@ vector<Vertex *> Graph::buildEulerianTour() {
 
         if (finished) break;
 
-        eulerianTour = mergePath(eulerianTour, getOneEulerianPath(curr));
+        mergePath(eulerianTour, getOneEulerianPath(curr));
     }
 
     return eulerianTour;
@@ -383,21 +576,19 @@ vector<Vertex *> Graph::getOneEulerianPath(Vertex *orig) {
 
             if (adj->getIsDouble()) {
                 adj->setIsDouble(false);
-                adj->getReverse()->setIsDouble(false);
                 adjOrig->setOutdegree(adjOrig->getOutdegree() - 1);
                 adjDest->setOutdegree(adjDest->getOutdegree() - 1);
-                eulerianPath.push_back(adj->getDest());
-                curr = adj->getDest();
+                curr = adj->getOther(curr);
+                eulerianPath.push_back(curr);
 
                 break;
             }
             else if (adj->getSelected()) {
                 adj->setSelected(false);
-                adj->getReverse()->setSelected(false);
                 adjOrig->setOutdegree(adjOrig->getOutdegree() - 1);
                 adjDest->setOutdegree(adjDest->getOutdegree() - 1);
-                eulerianPath.push_back(adj->getDest());
-                curr = adj->getDest();
+                curr = adj->getOther(curr);
+                eulerianPath.push_back(curr);
 
                 break;
             }
@@ -407,27 +598,18 @@ vector<Vertex *> Graph::getOneEulerianPath(Vertex *orig) {
     return eulerianPath;
 }
 
-vector<Vertex *> Graph::mergePath(vector<Vertex *> &eulerianTour, vector<Vertex *> path) {
-    int i = 0;
-    vector<Vertex *> newTour;
-
-    while (eulerianTour[i] != path[0])
-        newTour.push_back(eulerianTour[i++]);
-
-    for (Vertex *v: path)
-        newTour.push_back(v);
-
-    for (; i < eulerianTour.size(); i++)
-        newTour.push_back(eulerianTour[i]);
-
-    return newTour;
+void Graph::mergePath(vector<Vertex *> &eulerianTour, const vector<Vertex *> &path) {
+    auto position = find(eulerianTour.begin(), eulerianTour.end(), path[0]);
+    eulerianTour.insert(position, path.begin(), path.end());
 }
 
-vInt Graph::removeRepeatingVertexes(vector<Vertex *> path) {
+vInt Graph::removeRepeatingVertexes(const vector<Vertex *> &path) {
+    INSTRUMENT_SCOPE("removeRepeatingVertexes");
     vInt unique_path;
+    unique_path.reserve(vertexSet.size() + 1);
 
-    for (auto v: vertexSet) {
-        v.second->setVisited(false);
+    for (Vertex *v: vertexSet) {
+        v->setVisited(false);
     }
 
     for (Vertex *v: path) {
@@ -442,16 +624,20 @@ vInt Graph::removeRepeatingVertexes(vector<Vertex *> path) {
     return unique_path;
 }
 
-double Graph::calculateChrisDistance(vector<Vertex *> eulerianTour) {
-    unordered_set<Vertex *> visited;
+double Graph::calculateChrisDistance(const vector<Vertex *> &eulerianTour) {
+    INSTRUMENT_SCOPE("calculateChrisDistance");
     double dist = 0;
     int p1 = 0, p2 = 1;
 
-    visited.insert(eulerianTour[0]);
+    // The visited flags of the vertexes are used instead of a hash set, which would allocate a node per vertex
+    for (Vertex *v: vertexSet) {
+        v->setVisited(false);
+    }
+    eulerianTour[0]->setVisited(true);
 
     while (p2 != eulerianTour.size()) {
-        if (visited.find(eulerianTour[p2]) == visited.end() || p2 == eulerianTour.size() - 1) {
-            visited.insert(eulerianTour[p2]);
+        if (!eulerianTour[p2]->isVisited() || p2 == eulerianTour.size() - 1) {
+            eulerianTour[p2]->setVisited(true);
             dist += eulerianTour[p1]->findEdge(eulerianTour[p2]->getId())->getDistance();
             p1 = p2; p2++;
         }
@@ -463,6 +649,7 @@ double Graph::calculateChrisDistance(vector<Vertex *> eulerianTour) {
 }
 
 double Graph::christofides(vInt &path) {
+    INSTRUMENT_SCOPE("christofides");
     mstBuild();
 
     vector<Vertex *> oddDegreeVertices = findOddDegreeVertexes();
@@ -475,3 +662,1196 @@ double Graph::christofides(vInt &path) {
 
     return calculateChrisDistance(eulerianTour);
 }
+
+vector<vInt> Graph::buildCandidateLists(const vector<Vertex *> &cities, unsigned k, const vInt &only) {
+    vInt index(vertexSet.size(), -1);
+    for (int i = 0; i < cities.size(); i++)
+        index[cities[i]->getId()] = i;
+
+    vector<vInt> candidates(cities.size());
+    vector<pair<double, int>> near;
+    size_t count = only.empty() ? cities.size() : only.size();
+    for (size_t c = 0; c < count; c++) {
+        int i = only.empty() ? (int) c : only[c];
+        near.clear();
+        for (Edge *e: cities[i]->getAdj()) {
+            int j = index[e->getOther(cities[i])->getId()];
+            if (j != -1 && j != i)
+                near.emplace_back(e->getDistance(), j);
+        }
+        // With the metric closure a path through other vertexes may be shorter than an edge, so every city is scanned
+        // over the row of this city, which is only computed if it is not cached yet
+        if (closure != nullptr) {
+            near.clear();
+            MetricClosure::Row row = closure->row(cities[i]->getId());
+            for (int j = 0; j < cities.size(); j++) {
+                if (j == i) continue;
+                Scalar dist = (*row)[cities[j]->getId()];
+                near.emplace_back(isinf(dist) ? calculateTwoVerticesDist(cities[i], cities[j]) : dist, j);
+            }
+        } else if (near.size() < k) {
+            near.clear();
+            for (int j = 0; j < cities.size(); j++) {
+                if (j != i) near.emplace_back(calculateTwoVerticesDist(cities[i], cities[j]), j);
+            }
+        }
+
+        auto last = near.begin() + min<size_t>(k, near.size());
+        partial_sort(near.begin(), last, near.end());
+        for (auto it = near.begin(); it != last; it++)
+            candidates[i].push_back(it->second);
+    }
+
+    return candidates;
+}
+
+namespace {
+    const unsigned candidateListSize = 10; /**< Number of nearest cities considered by the local search moves */
+
+    /// One independent search chain, run on a tour of city indices.
+    typedef function<double(LocalSearch<GraphDistance> &, vInt &, double, mt19937 &, const SolveControl &)> Chain;
+
+    /**
+     * Runs independent copies of a search chain in parallel, each one from the tour in path and with its own seed,
+     * and keeps the best tour
+     * @return the distance of the best tour
+     */
+    double runChains(Graph &graph, vInt &path, double distance, const SolveControl &control, unsigned threads,
+                     unsigned seed, const Chain &chain) {
+        vector<Vertex *> cities;
+        for (auto i = 0; i < path.size() - 1; i++)
+            cities.push_back(graph.findVertex(path[i]));
+
+        GraphDistance dist(graph, cities);
+        vector<vInt> candidates = graph.buildCandidateLists(cities, candidateListSize);
+
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        vector<vInt> tours(threads);
+        vector<double> lengths(threads);
+
+        // Chains report to the caller only when they beat every other chain
+        mutex progressMutex;
+        double bestReported = distance;
+        SolveControl chainControl = control;
+        chainControl.setProgressCallback([&](double length) {
+            lock_guard<mutex> lock(progressMutex);
+            if (length < bestReported) {
+                bestReported = length;
+                control.reportProgress(length);
+            }
+        });
+
+        auto runChain = [&](unsigned c) {
+            LocalSearch<GraphDistance> localSearch(dist, candidates);
+            seed_seq seq = {seed, c};
+            mt19937 rng(seq);
+            tours[c].resize(cities.size());
+            for (int i = 0; i < cities.size(); i++) tours[c][i] = i;
+            lengths[c] = chain(localSearch, tours[c], LocalSearch<GraphDistance>::tourLength(dist, tours[c]), rng,
+                               chainControl);
+        };
+
+        vector<thread> workers;
+        for (unsigned c = 1; c < threads; c++)
+            workers.emplace_back(runChain, c);
+        runChain(0);
+        for (thread &worker: workers)
+            worker.join();
+        if (chainControl.wasStopped()) control.stop();
+
+        unsigned best = 0;
+        for (unsigned c = 1; c < threads; c++) {
+            if (lengths[c] < lengths[best]) best = c;
+        }
+        if (lengths[best] >= distance) return distance;
+
+        // Rotate the tour so that it starts at the same vertex as before
+        vInt &tour = tours[best];
+        rotate(tour.begin(), find(tour.begin(), tour.end(), 0), tour.end());
+        for (int i = 0; i < tour.size(); i++)
+            path[i] = cities[tour[i]]->getId();
+        path.back() = path.front();
+
+        return lengths[best];
+    }
+
+    /**
+     * Iterated local search chain: improves the tour with the local search, then applies double-bridge kicks followed
+     * by the local search around the kicked edges and keeps each kick only if it improves the tour. Each kick costs
+     * O(n) to load the tour into the local search and to keep or restore the best tour
+     * @return the length of the best tour found, which is left in tour
+     */
+    template <class Dist>
+    double iteratedLocalSearchChain(LocalSearch<Dist> &localSearch, vInt &tour, double length, mt19937 &rng,
+                                    const SolveControl &control) {
+        length = localSearch.optimize(tour, length, control);
+        control.reportProgress(length);
+        if (tour.size() < 8) return length;
+
+        unsigned long kicks = control.remainingSeconds() < 0 ? max<size_t>(100, tour.size()) : ULONG_MAX;
+        vInt best = tour, touched;
+        double bestLength = length;
+
+        for (unsigned long k = 0; k < kicks && !control.shouldStop(); k++) {
+            length = localSearch.doubleBridge(tour, bestLength, rng, touched);
+            length = localSearch.optimize(tour, length, touched, control);
+            if (length < bestLength - 1e-7) {
+                best = tour;
+                bestLength = length;
+                control.reportProgress(bestLength);
+            } else {
+                tour = best;
+            }
+        }
+
+        tour = best;
+        return bestLength;
+    }
+}
+
+double Graph::iteratedLocalSearch(vInt &path, double distance, const SolveControl &control, unsigned threads,
+                                  unsigned seed) {
+    INSTRUMENT_SCOPE("iteratedLocalSearch");
+    return runChains(*this, path, distance, control, threads, seed, iteratedLocalSearchChain<GraphDistance>);
+}
+
+double Graph::parallelTwoOpt(vInt &path, double distance, const SolveControl &control, unsigned threads) {
+    INSTRUMENT_SCOPE("parallelTwoOpt");
+    if (path.size() < 6) return distance;
+
+    // City i is the vertex at position i of the tour, so the first vertex stays first
+    vector<Vertex *> cities;
+    for (auto i = 0; i < path.size() - 1; i++)
+        cities.push_back(findVertex(path[i]));
+    vector<vInt> candidates = buildCandidateLists(cities, candidateListSize);
+
+    vInt tour(cities.size());
+    iota(tour.begin(), tour.end(), 0);
+    distance = withDistancePolicy(*this, cities, [&](const auto &dist) {
+        LocalSearch<typename decay<decltype(dist)>::type> localSearch(dist, candidates);
+        double length = localSearch.parallelTwoOpt(tour, distance, threads, control);
+        // Or-opt moves are left to a sequential pass, which starts from a 2-opt optimum and takes few moves
+        return localSearch.optimize(tour, length, control);
+    });
+
+    for (int i = 0; i < tour.size(); i++)
+        path[i] = cities[tour[i]]->getId();
+    return distance;
+}
+
+double Graph::simulatedAnnealing(vInt &path, double distance, const SolveControl &control, unsigned threads,
+                                 unsigned seed) {
+    INSTRUMENT_SCOPE("simulatedAnnealing");
+    return runChains(*this, path, distance, control, threads, seed,
+                     [](LocalSearch<GraphDistance> &localSearch, vInt &tour, double length, mt19937 &rng,
+                        const SolveControl &control) {
+        length = localSearch.anneal(tour, length, rng, 1000 * tour.size(), control);
+        // The polishing step ignores the deadline, it only takes a few local moves
+        return localSearch.optimize(tour, length, SolveControl());
+    });
+}
+
+void Graph::setMetricClosure(bool enabled, size_t maxRows) {
+    if (!enabled) {
+        closure = nullptr;
+        oracle->setMetricClosure(nullptr);
+        return;
+    }
+
+    closure = make_shared<MetricClosure>(vertexSet, maxRows);
+    oracle->setMetricClosure(closure);
+}
+
+bool Graph::usesMetricClosure() const {
+    return closure != nullptr;
+}
+
+shared_ptr<MetricClosure> Graph::getMetricClosure() const {
+    return closure;
+}
+
+void Graph::computeMetricClosure(unsigned threads) {
+    INSTRUMENT_SCOPE("computeMetricClosure");
+    if (closure != nullptr)
+        closure->computeAll(threads);
+}
+
+void Graph::buildEdgeIndexes() {
+    INSTRUMENT_SCOPE("buildEdgeIndexes");
+    for (Vertex *v: vertexSet)
+        v->buildEdgeIndex();
+}
+
+bool Graph::isComplete() const {
+    for (Vertex *v: vertexSet) {
+        if (v->getAdj().size() + 1 < vertexSet.size())
+            return false;
+    }
+    return true;
+}
+
+namespace {
+    const unsigned islandPopulation = 12; /**< Number of tours kept by each island of the genetic algorithm */
+    const unsigned generationsPerEpoch = 8; /**< Generations each island evolves between migrations */
+    const unsigned defaultEpochs = 25; /**< Number of epochs run when there is no deadline */
+
+    /// Population of one island of the genetic algorithm.
+    struct Island {
+        vector<vInt> tours;
+        vector<double> lengths;
+        mt19937 rng;
+    };
+
+    /**
+     * Order crossover (OX): copies a random slice of the first parent and fills the remaining positions with the
+     * other cities in the order they appear in the second parent, starting after the slice
+     */
+    vInt orderCrossover(const vInt &first, const vInt &second, mt19937 &rng) {
+        int n = (int) first.size();
+        int i = uniformInt(rng, 0, n - 1), j = uniformInt(rng, 0, n - 1);
+        if (i > j) swap(i, j);
+
+        vInt child(n);
+        vector<char> used(n, 0);
+        for (int k = i; k <= j; k++) {
+            child[k] = first[k];
+            used[first[k]] = 1;
+        }
+
+        int write = (j + 1) % n;
+        for (int k = 0; k < n; k++) {
+            int city = second[(j + 1 + k) % n];
+            if (used[city]) continue;
+            child[write] = city;
+            write = (write + 1) % n;
+        }
+        return child;
+    }
+
+    unsigned tournament(Island &island) {
+        int last = (int) island.tours.size() - 1;
+        unsigned a = uniformInt(island.rng, 0, last), b = uniformInt(island.rng, 0, last);
+        return island.lengths[a] <= island.lengths[b] ? a : b;
+    }
+
+    unsigned worstTour(const Island &island) {
+        return (unsigned) (max_element(island.lengths.begin(), island.lengths.end()) - island.lengths.begin());
+    }
+
+    unsigned bestTour(const Island &island) {
+        return (unsigned) (min_element(island.lengths.begin(), island.lengths.end()) - island.lengths.begin());
+    }
+
+    /**
+     * Replaces the worst tour of the island by the given one, if it is better and not already in the population
+     * (tours with the same length are considered duplicates)
+     */
+    void offerTour(Island &island, const vInt &tour, double length) {
+        unsigned worst = worstTour(island);
+        if (length >= island.lengths[worst]) return;
+        for (double other: island.lengths) {
+            if (fabs(other - length) < 1e-7) return;
+        }
+        island.tours[worst] = tour;
+        island.lengths[worst] = length;
+    }
+}
+
+double Graph::geneticAlgorithm(vInt &path, double distance, const SolveControl &control, unsigned islands,
+                               unsigned seed) {
+    INSTRUMENT_SCOPE("geneticAlgorithm");
+    size_t n = path.size() - 1;
+    if (n < 8) return distance;
+    if (islands == 0) islands = max(1u, thread::hardware_concurrency());
+
+    // The constructors use the vertex flags, so the seed tours are built before the islands start
+    vector<vInt> seeds = {path};
+    vInt nearest(n);
+    nearestNeighbourRouteTsp(nearest);
+    seeds.push_back(nearest);
+    if (isComplete()) {
+        vInt chris;
+        christofides(chris);
+        seeds.push_back(chris);
+    }
+
+    vector<Vertex *> cities;
+    vInt index(vertexSet.size(), -1);
+    for (int i = 0; i < n; i++) {
+        cities.push_back(findVertex(path[i]));
+        index[path[i]] = i;
+    }
+    GraphDistance dist(*this, cities);
+    vector<vInt> candidates = buildCandidateLists(cities, candidateListSize);
+
+    vector<vInt> seedTours;
+    vector<double> seedLengths;
+    LocalSearch<GraphDistance> polish(dist, candidates);
+    for (const vInt &s: seeds) {
+        vInt tour;
+        for (int i = 0; i < n; i++) tour.push_back(index[s[i]]);
+        double length = polish.optimize(tour, LocalSearch<GraphDistance>::tourLength(dist, tour), control);
+        seedTours.push_back(tour);
+        seedLengths.push_back(length);
+    }
+
+    vector<Island> population(islands);
+    vector<LocalSearch<GraphDistance>> localSearches(islands, LocalSearch<GraphDistance>(dist, candidates));
+    for (unsigned i = 0; i < islands; i++) {
+        seed_seq seq = {seed, i};
+        population[i].rng.seed(seq);
+    }
+
+    // Each island starts from every seed tour plus kicked and repaired variants of them
+    auto initIsland = [&](unsigned i) {
+        Island &island = population[i];
+        vInt touched;
+        for (unsigned k = 0; k < islandPopulation; k++) {
+            unsigned s = (i + k) % seedTours.size();
+            vInt tour = seedTours[s];
+            double length = seedLengths[s];
+            if (k >= seedTours.size()) {
+                for (int kick = 0; kick < 3; kick++)
+                    length = localSearches[i].doubleBridge(tour, length, island.rng, touched);
+                length = localSearches[i].optimize(tour, length, control);
+            }
+            island.tours.push_back(tour);
+            island.lengths.push_back(length);
+        }
+    };
+
+    auto evolveIsland = [&](unsigned i) {
+        Island &island = population[i];
+        vInt touched;
+        for (unsigned g = 0; g < generationsPerEpoch && !control.shouldStop(); g++) {
+            unsigned a = tournament(island), b = tournament(island);
+            vInt child = orderCrossover(island.tours[a], island.tours[b], island.rng);
+            double length = LocalSearch<GraphDistance>::tourLength(dist, child);
+            if (uniformReal(island.rng) < 0.1)
+                length = localSearches[i].doubleBridge(child, length, island.rng, touched);
+            length = localSearches[i].optimize(child, length, control);
+            offerTour(island, child, length);
+        }
+    };
+
+    auto parallelIslands = [&](const function<void(unsigned)> &work) {
+        vector<thread> workers;
+        for (unsigned i = 1; i < islands; i++)
+            workers.emplace_back(work, i);
+        work(0);
+        for (thread &worker: workers)
+            worker.join();
+    };
+
+    parallelIslands(initIsland);
+
+    double bestLength = distance;
+    bool noDeadline = control.remainingSeconds() < 0;
+    for (unsigned epoch = 0; !control.shouldStop() && (!noDeadline || epoch < defaultEpochs); epoch++) {
+        parallelIslands(evolveIsland);
+
+        // Ring migration, done sequentially between epochs so the result only depends on the seed
+        vector<unsigned> migrants;
+        for (const Island &island: population)
+            migrants.push_back(bestTour(island));
+        for (unsigned i = 0; i < islands && islands > 1; i++) {
+            const Island &from = population[i];
+            offerTour(population[(i + 1) % islands], from.tours[migrants[i]], from.lengths[migrants[i]]);
+        }
+
+        for (const Island &island: population) {
+            double length = island.lengths[bestTour(island)];
+            if (length < bestLength) {
+                bestLength = length;
+                control.reportProgress(bestLength);
+            }
+        }
+    }
+
+    unsigned bestIsland = 0;
+    for (unsigned i = 1; i < islands; i++) {
+        const Island &current = population[i], &incumbent = population[bestIsland];
+        if (current.lengths[bestTour(current)] < incumbent.lengths[bestTour(incumbent)])
+            bestIsland = i;
+    }
+    const Island &island = population[bestIsland];
+    unsigned best = bestTour(island);
+    if (island.lengths[best] >= distance) return distance;
+
+    vInt tour = island.tours[best];
+    rotate(tour.begin(), find(tour.begin(), tour.end(), 0), tour.end());
+    for (int i = 0; i < n; i++)
+        path[i] = cities[tour[i]]->getId();
+    path.back() = path.front();
+
+    return island.lengths[best];
+}
+
+namespace {
+    const unsigned hilbertOrderBits = 16; /**< The curve is laid over a 2^16 x 2^16 grid */
+
+    /**
+     * Computes the distance of a cell along the Hilbert curve that fills the grid
+     * @param x column of the cell
+     * @param y row of the cell
+     * @return the index of the cell along the curve
+     */
+    unsigned long long hilbertIndex(unsigned x, unsigned y) {
+        const unsigned side = 1u << hilbertOrderBits;
+        unsigned long long d = 0;
+        for (unsigned s = side / 2; s > 0; s /= 2) {
+            unsigned rx = (x & s) > 0;
+            unsigned ry = (y & s) > 0;
+            d += (unsigned long long) s * s * ((3 * rx) ^ ry);
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = side - 1 - x;
+                    y = side - 1 - y;
+                }
+                swap(x, y);
+            }
+        }
+        return d;
+    }
+}
+
+vector<Vertex *> Graph::hilbertOrder() const {
+    double minLat = DBL_MAX, maxLat = -DBL_MAX, minLon = DBL_MAX, maxLon = -DBL_MAX;
+    for (Vertex *v: vertexSet) {
+        minLat = min(minLat, v->getLatitude());
+        maxLat = max(maxLat, v->getLatitude());
+        minLon = min(minLon, v->getLongitude());
+        maxLon = max(maxLon, v->getLongitude());
+    }
+
+    // Same scale on both axes so that the curve preserves distances
+    double span = max(maxLat - minLat, maxLon - minLon);
+    double scale = span > 0 ? ((1u << hilbertOrderBits) - 1) / span : 0;
+
+    vector<pair<unsigned long long, Vertex *>> keyed;
+    for (Vertex *v: vertexSet) {
+        auto x = (unsigned) ((v->getLongitude() - minLon) * scale);
+        auto y = (unsigned) ((v->getLatitude() - minLat) * scale);
+        keyed.emplace_back(hilbertIndex(x, y), v);
+    }
+    sort(keyed.begin(), keyed.end(), [](const pair<unsigned long long, Vertex *> &a,
+                                        const pair<unsigned long long, Vertex *> &b) {
+        return a.first != b.first ? a.first < b.first : a.second->getId() < b.second->getId();
+    });
+
+    vector<Vertex *> order;
+    for (auto &k: keyed)
+        order.push_back(k.second);
+    return order;
+}
+
+double Graph::hilbertCurveTsp(vInt &path) {
+    INSTRUMENT_SCOPE("hilbertCurveTsp");
+    vector<Vertex *> order = hilbertOrder();
+    rotate(order.begin(), find(order.begin(), order.end(), findVertex(0)), order.end());
+
+    path.clear();
+    double totalDistance = 0;
+    for (int i = 0; i < order.size(); i++) {
+        path.push_back(order[i]->getId());
+        totalDistance += calculateTwoVerticesDist(order[i], order[(i + 1) % order.size()]);
+    }
+    path.push_back(0);
+
+    return totalDistance;
+}
+
+void Graph::spatialRenumber() {
+    INSTRUMENT_SCOPE("spatialRenumber");
+    vector<Vertex *> order = hilbertOrder();
+    rotate(order.begin(), find(order.begin(), order.end(), findVertex(0)), order.end());
+
+    vInt newOriginalIds;
+    for (int i = 0; i < order.size(); i++) {
+        newOriginalIds.push_back(getOriginalId(order[i]->getId()));
+        order[i]->setId(i);
+        denseIds[newOriginalIds[i]] = i;
+    }
+    originalIds = newOriginalIds;
+    vertexSet = order;
+
+    for (Vertex *v: order)
+        v->sortAdjByDest();
+    buildEdgeIndexes();
+
+    // The cached distances are indexed by the old ids
+    oracle->clear();
+    if (closure != nullptr)
+        setMetricClosure(true, closure->getMaxRows());
+}
+
+namespace {
+    /// Union-find over city indices, used to reject edges that would close a cycle.
+    struct DisjointSets {
+        vInt leader;
+
+        explicit DisjointSets(size_t n) : leader(n) {
+            for (int i = 0; i < n; i++) leader[i] = i;
+        }
+
+        int find(int i) {
+            while (leader[i] != i) {
+                leader[i] = leader[leader[i]];
+                i = leader[i];
+            }
+            return i;
+        }
+
+        bool unite(int i, int j) {
+            i = find(i);
+            j = find(j);
+            if (i == j) return false;
+            leader[i] = j;
+            return true;
+        }
+    };
+
+    /// An edge between two city indices, with the key it is sorted by.
+    struct RankedEdge {
+        double key;
+        int from, to;
+
+        bool operator<(const RankedEdge &other) const {
+            if (key != other.key) return key < other.key;
+            return from != other.from ? from < other.from : to < other.to;
+        }
+    };
+
+    /**
+     * Adds the ranked edges, in order, to a set of vertex-disjoint paths: an edge is kept if both cities have fewer
+     * than two neighbours and it does not close a cycle
+     * @return the neighbours of each city in its path, -1 if there is none
+     */
+    vector<array<int, 2>> linkEdges(size_t n, const vector<RankedEdge> &edges, int skip) {
+        vector<array<int, 2>> links(n, {-1, -1});
+        vInt degree(n, 0);
+        DisjointSets sets(n);
+        size_t linked = 0;
+
+        for (const RankedEdge &e: edges) {
+            if (linked + 1 >= n) break;
+            if (e.from == skip || e.to == skip || degree[e.from] == 2 || degree[e.to] == 2) continue;
+            if (!sets.unite(e.from, e.to)) continue;
+            links[e.from][degree[e.from]++] = e.to;
+            links[e.to][degree[e.to]++] = e.from;
+            linked++;
+        }
+        return links;
+    }
+}
+
+double Graph::joinPathFragments(const vector<Vertex *> &cities, const vector<array<int, 2>> &links, vInt &path) {
+    size_t n = cities.size();
+    vector<char> visited(n, 0);
+    vInt order;
+
+    // Appends the path that has the endpoint "from", walking to its other endpoint
+    auto walk = [&](int from) {
+        int prev = -1, curr = from;
+        while (curr != -1) {
+            visited[curr] = 1;
+            order.push_back(curr);
+            int next = links[curr][0] != prev ? links[curr][0] : links[curr][1];
+            prev = curr;
+            curr = next == -1 || visited[next] ? -1 : next;
+        }
+    };
+
+    int start = 0;
+    while (start < n && cities[start]->getId() != 0) start++;
+    if (start == n) start = 0;
+
+    // Find an endpoint of the path that contains the start
+    int prev = -1, curr = start;
+    while (links[curr][1] != -1) {
+        int next = links[curr][0] != prev ? links[curr][0] : links[curr][1];
+        if (next == start) break; // cannot happen for paths, kept as a guard
+        prev = curr;
+        curr = next;
+    }
+    walk(curr);
+
+    vInt endpoints;
+    for (int i = 0; i < n; i++) {
+        if (links[i][1] == -1) endpoints.push_back(i);
+    }
+
+    while (order.size() < n) {
+        Vertex *last = cities[order.back()];
+        int nearest = -1;
+        double nearestDist = DBL_MAX;
+        for (int e: endpoints) {
+            if (visited[e]) continue;
+            double d = calculateTwoVerticesDist(last, cities[e]);
+            if (d < nearestDist) {
+                nearestDist = d;
+                nearest = e;
+            }
+        }
+        walk(nearest);
+    }
+
+    rotate(order.begin(), find(order.begin(), order.end(), start), order.end());
+    path.clear();
+    double totalDistance = 0;
+    for (int i = 0; i < n; i++) {
+        path.push_back(cities[order[i]]->getId());
+        totalDistance += calculateTwoVerticesDist(cities[order[i]], cities[order[(i + 1) % n]]);
+    }
+    path.push_back(path.front());
+
+    return totalDistance;
+}
+
+double Graph::greedyEdgeTsp(vInt &path) {
+    INSTRUMENT_SCOPE("greedyEdgeTsp");
+    // Vertex ids are dense, so a city is identified by the id of its vertex
+    const vector<Vertex *> &cities = vertexSet;
+
+    vector<RankedEdge> edges;
+    edges.reserve(edgeSet.size());
+    for (const Edge &e: edgeSet) {
+        int i = e.getOrig()->getId(), j = e.getDest()->getId();
+        if (i > j) swap(i, j);
+        if (i < j) edges.push_back({e.getDistance(), i, j});
+    }
+    parallelSort(edges.begin(), edges.end(), less<RankedEdge>());
+
+    return joinPathFragments(cities, linkEdges(cities.size(), edges, -1), path);
+}
+
+double Graph::savingsTsp(vInt &path) {
+    INSTRUMENT_SCOPE("savingsTsp");
+    const vector<Vertex *> &cities = vertexSet;
+
+    int hub = 0;
+    vector<double> hubDist(cities.size());
+    for (int i = 0; i < cities.size(); i++)
+        hubDist[i] = calculateTwoVerticesDist(cities[hub], cities[i]);
+
+    // Sorting by negative saving puts the largest savings first
+    vector<RankedEdge> savings;
+    for (const Edge &e: edgeSet) {
+        int i = e.getOrig()->getId(), j = e.getDest()->getId();
+        if (i > j) swap(i, j);
+        if (i < j && i != hub && j != hub)
+            savings.push_back({e.getDistance() - hubDist[i] - hubDist[j], i, j});
+    }
+    parallelSort(savings.begin(), savings.end(), less<RankedEdge>());
+
+    return joinPathFragments(cities, linkEdges(cities.size(), savings, hub), path);
+}
+
+double Graph::insertionTsp(vInt &path, insertion_rule rule, unsigned seed) {
+    INSTRUMENT_SCOPE("insertionTsp");
+    const vector<Vertex *> &cities = vertexSet;
+    int n = (int) cities.size();
+
+    path.clear();
+    if (n < 3) {
+        double totalDistance = 0;
+        for (int i = 0; i < n; i++) {
+            path.push_back(cities[i]->getId());
+            totalDistance += calculateTwoVerticesDist(cities[i], cities[(i + 1) % n]);
+        }
+        path.push_back(cities.front()->getId());
+        return totalDistance;
+    }
+
+    int start = 0;
+    while (start < n && cities[start]->getId() != 0) start++;
+    if (start == n) start = 0;
+
+    return withDistancePolicy(*this, cities, [&](const auto &dist) {
+        // Second vertex of the initial tour
+        vector<double> startDist(n);
+        int second = -1;
+        for (int i = 0; i < n; i++) {
+            if (i == start) continue;
+            startDist[i] = dist(start, i);
+            if (second == -1 || (rule == farthest_insertion ? startDist[i] > startDist[second]
+                                                             : startDist[i] < startDist[second]))
+                second = i;
+        }
+
+        vInt next(n, -1);
+        next[start] = second;
+        next[second] = start;
+
+        // Vertexes not in the tour yet, with their cached best insertion edge (from -> next[from]) and its cost
+        vInt remaining, bestFrom(n);
+        vector<double> bestCost(n), tourDist(n);
+        for (int i = 0; i < n; i++) {
+            if (i == start || i == second) continue;
+            remaining.push_back(i);
+            double toSecond = dist(second, i);
+            bestFrom[i] = start;
+            bestCost[i] = startDist[i] + toSecond - startDist[second];
+            tourDist[i] = min(startDist[i], toSecond);
+        }
+
+        auto insertionCost = [&](int w, int a) { return dist(a, w) + dist(w, next[a]) - dist(a, next[a]); };
+
+        mt19937 rng(seed);
+        if (rule == random_insertion)
+            uniformShuffle(remaining.begin(), remaining.end(), rng);
+
+        double totalDistance = 2 * startDist[second];
+        while (!remaining.empty()) {
+            size_t chosen = remaining.size() - 1;
+            if (rule != random_insertion) {
+                for (size_t r = 0; r < remaining.size(); r++) {
+                    int w = remaining[r], c = remaining[chosen];
+                    if (rule == cheapest_insertion ? bestCost[w] < bestCost[c] : tourDist[w] > tourDist[c])
+                        chosen = r;
+                }
+            }
+            int u = remaining[chosen];
+            remaining[chosen] = remaining.back();
+            remaining.pop_back();
+
+            int a = bestFrom[u], b = next[a];
+            totalDistance += bestCost[u];
+            next[a] = u;
+            next[u] = b;
+
+            for (int w: remaining) {
+                // The cached edge (a, b) may no longer exist. Every other edge costs at least as much as it did, so if one
+                // of the two new edges costs no more it is the best one, otherwise every edge is tried again
+                bool split = bestFrom[w] == a;
+                double previousCost = bestCost[w];
+                if (split) bestCost[w] = DBL_MAX;
+                for (int from: {a, u}) {
+                    double cost = insertionCost(w, from);
+                    if (cost < bestCost[w]) {
+                        bestCost[w] = cost;
+                        bestFrom[w] = from;
+                    }
+                }
+                if (split && bestCost[w] > previousCost) {
+                    int from = next[u];
+                    while (from != a) {
+                        double cost = insertionCost(w, from);
+                        if (cost < bestCost[w]) {
+                            bestCost[w] = cost;
+                            bestFrom[w] = from;
+                        }
+                        from = next[from];
+                    }
+                }
+                if (rule == farthest_insertion)
+                    tourDist[w] = min(tourDist[w], dist(u, w));
+            }
+        }
+
+        int curr = start;
+        do {
+            path.push_back(cities[curr]->getId());
+            curr = next[curr];
+        } while (curr != start);
+        path.push_back(cities[start]->getId());
+
+        return totalDistance;
+    });
+}
+
+namespace {
+    /**
+     * Splits a range of vertexes in two halves at the median latitude or longitude, whichever spreads more, until
+     * every part has at most clusterSize vertexes. Parts whose vertexes all have the same coordinates are not split
+     */
+    void bisect(vector<Vertex *>::iterator first, vector<Vertex *>::iterator last, size_t clusterSize,
+                vector<vector<Vertex *>> &clusters) {
+        double minLat = DBL_MAX, maxLat = -DBL_MAX, minLon = DBL_MAX, maxLon = -DBL_MAX;
+        for (auto it = first; it != last; it++) {
+            minLat = min(minLat, (*it)->getLatitude());
+            maxLat = max(maxLat, (*it)->getLatitude());
+            minLon = min(minLon, (*it)->getLongitude());
+            maxLon = max(maxLon, (*it)->getLongitude());
+        }
+        size_t n = last - first;
+        if (n <= clusterSize || (maxLat == minLat && maxLon == minLon)) {
+            clusters.emplace_back(first, last);
+            return;
+        }
+
+        bool byLongitude = maxLon - minLon >= maxLat - minLat;
+        auto mid = first + n / 2;
+        nth_element(first, mid, last, [byLongitude](const Vertex *a, const Vertex *b) {
+            double ka = byLongitude ? a->getLongitude() : a->getLatitude();
+            double kb = byLongitude ? b->getLongitude() : b->getLatitude();
+            return ka != kb ? ka < kb : a->getId() < b->getId();
+        });
+        bisect(first, mid, clusterSize, clusters);
+        bisect(mid, last, clusterSize, clusters);
+    }
+
+    /// Mean latitude and longitude of the vertexes of a cluster.
+    struct Centroid {
+        double latitude = 0, longitude = 0;
+    };
+}
+
+double Graph::partitionTsp(vInt &path, const SolveControl &control, unsigned threads, unsigned clusterSize) {
+    INSTRUMENT_SCOPE("partitionTsp");
+    vector<vector<Vertex *>> clusters;
+    vector<Vertex *> vertexes = vertexSet;
+    bisect(vertexes.begin(), vertexes.end(), max(clusterSize, 3u), clusters);
+    size_t k = clusters.size();
+
+    // Clusters are visited in the order of their centroids along the Hilbert curve, from the one with vertex 0
+    vector<Centroid> centroids(k);
+    double minLat = DBL_MAX, maxLat = -DBL_MAX, minLon = DBL_MAX, maxLon = -DBL_MAX;
+    for (size_t c = 0; c < k; c++) {
+        for (Vertex *v: clusters[c]) {
+            centroids[c].latitude += v->getLatitude() / (double) clusters[c].size();
+            centroids[c].longitude += v->getLongitude() / (double) clusters[c].size();
+        }
+        minLat = min(minLat, centroids[c].latitude);
+        maxLat = max(maxLat, centroids[c].latitude);
+        minLon = min(minLon, centroids[c].longitude);
+        maxLon = max(maxLon, centroids[c].longitude);
+    }
+    double span = max(maxLat - minLat, maxLon - minLon);
+    double scale = span > 0 ? ((1u << hilbertOrderBits) - 1) / span : 0;
+    vector<pair<unsigned long long, size_t>> keyed;
+    for (size_t c = 0; c < k; c++) {
+        auto x = (unsigned) ((centroids[c].longitude - minLon) * scale);
+        auto y = (unsigned) ((centroids[c].latitude - minLat) * scale);
+        keyed.emplace_back(hilbertIndex(x, y), c);
+    }
+    sort(keyed.begin(), keyed.end());
+    vector<size_t> clusterOrder;
+    for (auto &key: keyed)
+        clusterOrder.push_back(key.second);
+    auto home = find_if(clusterOrder.begin(), clusterOrder.end(), [&](size_t c) {
+        return find(clusters[c].begin(), clusters[c].end(), findVertex(0)) != clusters[c].end();
+    });
+    rotate(clusterOrder.begin(), home, clusterOrder.end());
+
+    // Each cluster gets a greedy edge tour over its candidate edges, improved by the local search. The clusters need
+    // the closure row of every city, so the rows are computed up front with every core instead of one by one
+    computeMetricClosure();
+    vInt localIndex(vertexSet.size());
+    vector<vector<Vertex *>> tours(k);
+    atomic<size_t> nextCluster(0);
+    auto solveClusters = [&]() {
+        for (size_t c = nextCluster++; c < k; c = nextCluster++) {
+            const vector<Vertex *> &cities = clusters[c];
+            for (int i = 0; i < cities.size(); i++)
+                localIndex[cities[i]->getId()] = i;
+            if (cities.size() < 5) {
+                tours[c] = cities;
+                continue;
+            }
+
+            GraphDistance dist(*this, cities);
+            vector<vInt> candidates = buildCandidateLists(cities, candidateListSize);
+            vector<RankedEdge> edges;
+            for (int i = 0; i < cities.size(); i++) {
+                for (int j: candidates[i])
+                    edges.push_back({dist(i, j), min(i, j), max(i, j)});
+            }
+            sort(edges.begin(), edges.end());
+
+            vInt clusterPath;
+            joinPathFragments(cities, linkEdges(cities.size(), edges, -1), clusterPath);
+            vInt tour;
+            for (int i = 0; i + 1 < clusterPath.size(); i++)
+                tour.push_back(localIndex[clusterPath[i]]);
+
+            LocalSearch<GraphDistance> localSearch(dist, candidates);
+            localSearch.optimize(tour, LocalSearch<GraphDistance>::tourLength(dist, tour), control);
+            for (int i: tour)
+                tours[c].push_back(cities[i]);
+        }
+    };
+
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads && t < k; t++)
+        workers.emplace_back(solveClusters);
+    solveClusters();
+    for (thread &worker: workers)
+        worker.join();
+
+    // Each cluster tour is entered at its vertex nearest to the previous exit and left towards the next cluster
+    vector<Vertex *> cities;
+    vInt clusterOf;
+    vInt active;
+    for (size_t i = 0; i < k; i++) {
+        const vector<Vertex *> &tour = tours[clusterOrder[i]];
+        int n = (int) tour.size();
+        int entry = 0;
+        if (i == 0) {
+            entry = (int) (find(tour.begin(), tour.end(), findVertex(0)) - tour.begin());
+        } else {
+            double nearest = DBL_MAX;
+            for (int j = 0; j < n; j++) {
+                double d = calculateTwoVerticesDist(cities.back(), tour[j]);
+                if (d < nearest) {
+                    nearest = d;
+                    entry = j;
+                }
+            }
+        }
+
+        Centroid target = i + 1 < k ? centroids[clusterOrder[i + 1]] : centroids[clusterOrder[0]];
+        auto targetDist = [&](Vertex *v) {
+            return DistanceOracle::haversine(v->getLatitude(), v->getLongitude(), target.latitude, target.longitude);
+        };
+        int step = targetDist(tour[(entry + n - 1) % n]) <= targetDist(tour[(entry + 1) % n]) ? 1 : n - 1;
+
+        active.push_back((int) cities.size());
+        for (int j = 0, at = entry; j < n; j++, at = (at + step) % n) {
+            cities.push_back(tour[at]);
+            clusterOf.push_back((int) i);
+        }
+        active.push_back((int) cities.size() - 1);
+    }
+
+    // Global pass, starting only from the cities that have candidates in another cluster and the stitching points
+    GraphDistance dist(*this, cities);
+    vInt tour(cities.size());
+    for (int i = 0; i < tour.size(); i++) tour[i] = i;
+    double length = LocalSearch<GraphDistance>::tourLength(dist, tour);
+    if (k > 1) {
+        vector<vInt> candidates = buildCandidateLists(cities, candidateListSize);
+        for (int i = 0; i < cities.size(); i++) {
+            for (int j: candidates[i]) {
+                if (clusterOf[j] != clusterOf[i]) {
+                    active.push_back(i);
+                    break;
+                }
+            }
+        }
+        LocalSearch<GraphDistance> localSearch(dist, candidates);
+        length = localSearch.optimize(tour, length, active, control);
+    }
+
+    rotate(tour.begin(), find(tour.begin(), tour.end(), 0), tour.end());
+    path.clear();
+    for (int i: tour)
+        path.push_back(cities[i]->getId());
+    path.push_back(path.front());
+
+    control.reportProgress(length);
+    return length;
+}
+
+double Graph::subsetTsp(const vInt &ids, vInt &path, const SolveControl &control, unsigned threads, unsigned seed) {
+    INSTRUMENT_SCOPE("subsetTsp");
+    int n = (int) ids.size();
+    path.clear();
+    if (n == 0) return 0;
+
+    vector<Vertex *> cities;
+    unordered_map<int, int> index;
+    for (int i = 0; i < n; i++) {
+        Vertex *v = findVertex(ids[i]);
+        if (v == nullptr) throw invalid_argument("unknown vertex " + to_string(ids[i]));
+        if (!index.emplace(ids[i], i).second)
+            throw invalid_argument("vertex " + to_string(getOriginalId(ids[i])) + " is repeated");
+        cities.push_back(v);
+    }
+
+    // Distance submatrix, the rows are split between the threads
+    vector<double> matrix((size_t) n * n, 0);
+    atomic<int> nextRow(0);
+    auto fillRows = [&]() {
+        for (int i = nextRow++; i < n; i = nextRow++) {
+            for (int j = 0; j < n; j++) {
+                if (j != i) matrix[(size_t) i * n + j] = calculateTwoVerticesDist(cities[i], cities[j]);
+            }
+        }
+    };
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads && t < n; t++)
+        workers.emplace_back(fillRows);
+    fillRows();
+    for (thread &worker: workers)
+        worker.join();
+    MatrixDistance dist(matrix, n);
+
+    vInt tour;
+    if (n < 4) {
+        for (int i = 0; i < n; i++) tour.push_back(i);
+    } else {
+        // Greedy edge tour over every pair of the subset
+        vector<RankedEdge> edges;
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++)
+                edges.push_back({dist(i, j), i, j});
+        }
+        parallelSort(edges.begin(), edges.end(), less<RankedEdge>(), threads);
+        vInt greedyPath;
+        joinPathFragments(cities, linkEdges(n, edges, -1), greedyPath);
+        for (int i = 0; i + 1 < greedyPath.size(); i++)
+            tour.push_back(index[greedyPath[i]]);
+
+        vector<vInt> candidates(n);
+        vector<pair<double, int>> near;
+        for (int i = 0; i < n; i++) {
+            near.clear();
+            for (int j = 0; j < n; j++) {
+                if (j != i) near.emplace_back(dist(i, j), j);
+            }
+            auto last = near.begin() + min<size_t>(candidateListSize, near.size());
+            partial_sort(near.begin(), last, near.end());
+            for (auto it = near.begin(); it != last; it++)
+                candidates[i].push_back(it->second);
+        }
+
+        LocalSearch<MatrixDistance> localSearch(dist, candidates);
+        mt19937 rng(seed);
+        iteratedLocalSearchChain(localSearch, tour, LocalSearch<MatrixDistance>::tourLength(dist, tour), rng, control);
+    }
+
+    rotate(tour.begin(), find(tour.begin(), tour.end(), 0), tour.end());
+    for (int i: tour)
+        path.push_back(ids[i]);
+    path.push_back(ids[0]);
+    return LocalSearch<MatrixDistance>::tourLength(dist, tour);
+}
+
+double Graph::reoptimize(vInt &path, const TourDelta &delta, const SolveControl &control) {
+    INSTRUMENT_SCOPE("reoptimize");
+    vector<char> removed(vertexSet.size(), false), inTour(vertexSet.size(), false), changed(vertexSet.size(), false);
+
+    // The delta is checked before anything changes, so path is left as it was when it is rejected
+    vector<char> stop(vertexSet.size(), false);
+    for (int id: path) {
+        if (findVertex(id) == nullptr) throw invalid_argument("unknown vertex " + to_string(id) + " in the tour");
+        stop[id] = true;
+    }
+    for (int id: delta.removed) {
+        if (findVertex(id) == nullptr) throw invalid_argument("unknown vertex " + to_string(id));
+        if (!stop[id]) throw invalid_argument("vertex " + to_string(getOriginalId(id)) + " is not in the tour");
+        removed[id] = true;
+    }
+    for (int id: delta.inserted) {
+        if (findVertex(id) == nullptr) throw invalid_argument("unknown vertex " + to_string(id));
+        if (stop[id] && !removed[id])
+            throw invalid_argument("vertex " + to_string(getOriginalId(id)) + " is already in the tour");
+    }
+    for (const array<int, 2> &edge: delta.changedEdges) {
+        for (int id: edge) {
+            if (findVertex(id) == nullptr) throw invalid_argument("unknown vertex " + to_string(id));
+        }
+        if (findVertex(edge[0])->findEdge(edge[1]) == nullptr) {
+            throw invalid_argument("no edge between " + to_string(getOriginalId(edge[0])) + " and " +
+                                   to_string(getOriginalId(edge[1])));
+        }
+    }
+
+    // Removed stops are skipped, their neighbours are joined by a new edge
+    vInt tour;
+    size_t stops = path.size() > 1 && path.front() == path.back() ? path.size() - 1 : path.size();
+    bool gap = false;
+    for (size_t i = 0; i < stops; i++) {
+        int id = path[i];
+        if (removed[id] || inTour[id]) {
+            if (!tour.empty()) changed[tour.back()] = true;
+            gap = true;
+            continue;
+        }
+        if (gap) changed[id] = true;
+        gap = false;
+        inTour[id] = true;
+        tour.push_back(id);
+    }
+    if (gap && !tour.empty()) changed[tour.front()] = true;
+    if (!tour.empty() && tour[0] != path[0]) changed[tour.back()] = true;
+    int start = tour.empty() ? -1 : tour[0];
+
+    // Cheapest insertion of each new stop. The tour is kept as a list of successors while stops are inserted, so each
+    // insertion only costs the scan for its position, and is turned back into a vector once
+    vInt next(vertexSet.size(), -1);
+    for (size_t i = 0; i < tour.size(); i++)
+        next[tour[i]] = tour[i + 1 == tour.size() ? 0 : i + 1];
+    size_t tourSize = tour.size();
+    for (int id: delta.inserted) {
+        if (inTour[id]) continue;
+        inTour[id] = true;
+        changed[id] = true;
+        if (start == -1) {
+            start = next[id] = id;
+            tourSize = 1;
+            continue;
+        }
+        Vertex *v = vertexSet[id];
+        int best = start;
+        double bestIncrease = DBL_MAX;
+        int a = start;
+        for (size_t i = 0; i < tourSize; i++, a = next[a]) {
+            double increase = calculateTwoVerticesDist(vertexSet[a], v) +
+                              calculateTwoVerticesDist(v, vertexSet[next[a]]) -
+                              calculateTwoVerticesDist(vertexSet[a], vertexSet[next[a]]);
+            if (increase < bestIncrease) {
+                bestIncrease = increase;
+                best = a;
+            }
+        }
+        next[id] = next[best];
+        next[best] = id;
+        tourSize++;
+    }
+    if (tourSize != tour.size()) {
+        tour.clear();
+        int a = start;
+        for (size_t i = 0; i < tourSize; i++, a = next[a])
+            tour.push_back(a);
+    }
+
+    for (const array<int, 2> &edge: delta.changedEdges) {
+        for (int id: edge) {
+            if (inTour[id]) changed[id] = true;
+        }
+    }
+
+    size_t n = tour.size();
+    vector<Vertex *> cities(n);
+    vInt local(n), active;
+    for (size_t i = 0; i < n; i++) {
+        cities[i] = vertexSet[tour[i]];
+        local[i] = (int) i;
+        if (changed[tour[i]]) active.push_back((int) i);
+    }
+
+    // Only the changed cities and their nearest cities get candidate lists, so the search cannot wander off
+    GraphDistance dist(*this, cities);
+    vector<vInt> candidates = buildCandidateLists(cities, candidateListSize, active);
+    vInt around;
+    vector<char> listed(n, false);
+    for (int i: active) listed[i] = true;
+    for (int i: active) {
+        for (int c: candidates[i]) {
+            if (!listed[c]) {
+                listed[c] = true;
+                around.push_back(c);
+            }
+        }
+    }
+    vector<vInt> aroundCandidates = buildCandidateLists(cities, candidateListSize, around);
+    for (int i: around)
+        candidates[i] = std::move(aroundCandidates[i]);
+
+    LocalSearch<GraphDistance> localSearch(dist, candidates);
+    double length = localSearch.optimize(local, LocalSearch<GraphDistance>::tourLength(dist, local), active, control);
+
+    path.clear();
+    size_t first = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (tour[local[i]] == start) first = i;
+    }
+    for (size_t i = 0; i < n; i++)
+        path.push_back(tour[local[(first + i) % n]]);
+    if (n > 0) path.push_back(path.front());
+    return length;
+}
@@ -5,7 +5,9 @@
 
 #include <iostream>
 #include <vector>
+#include <array>
 #include <queue>
+#include <deque>
 #include <limits>
 #include <algorithm>
 #include <unordered_map>
@@ -15,10 +17,15 @@
 #include <cfloat>
 #include <cmath>
 #include "VertexEdge.h"
+#include "Instrumentation.h"
+#include "SolveControl.h"
 #include "MutablePriorityQueue.h"
+#include "MetricClosure.h"
+#include "DistanceOracle.h"
 #include "Graph.h"
 #include "chrono"
 #include <unordered_set>
+#include <memory>
 
 using namespace std;
 
@@ -27,11 +34,33 @@ typedef vector<int> vInt;
 
 class Graph {
 public:
+
+    /// Defines how the insertion heuristic chooses the next vertex to insert.
+    enum insertion_rule {
+        cheapest_insertion,
+        farthest_insertion,
+        random_insertion
+    };
+
+    /// Changes to the stops of a tour and to the graph since the tour was computed, see reoptimize.
+    struct TourDelta {
+        vInt inserted; /**< Vertexes the tour must now visit, usually just added to the graph */
+        vInt removed; /**< Vertexes the tour must no longer visit */
+        vector<array<int, 2>> changedEdges; /**< Vertex pairs whose edge length changed, see setEdgeDistance */
+    };
+
+    Graph() = default;
+
     /**
-     * Graph's destructor
+     * Graph's destructor, deletes the vertexes
      */
     ~Graph();
 
+    /// The graph owns its vertexes and edges, so it cannot be copied.
+    Graph(const Graph &) = delete;
+
+    Graph &operator=(const Graph &) = delete;
+
     /**
      * Auxiliary function to find a vertex with a given id
      * Complexity: O(1)
@@ -41,20 +70,38 @@ public:
     Vertex *findVertex(const int &id) const;
 
     /**
-     * Adds a vertex to a graph (this)
-     * Complexity: O(1)
+     * Auxiliary function to find a vertex with the id it has in the input files
+     * Complexity: O(1) on average
+     * @param originalId - the id of the vertex in the input files
+     * @return the vertex with the given id or nullptr if it isn't found
+     */
+    Vertex *findVertexByOriginalId(int originalId) const;
+
+    /**
+     * Adds a vertex to a graph (this). The id of the vertex is taken as its input id and replaced by the next dense
+     * id, so the vertexes of a graph are always numbered 0..V-1. The vertex with input id 0 always gets id 0, the
+     * vertex it replaces gets the next id. Ids must not change after edge indexes or distances are cached
+     * Complexity: O(1) on average
      * @param v - the vertex to be added
      * @return true - if successful
-     *         false - if a vertex with that id already exists
+     *         false - if a vertex with that input id already exists
      */
     bool addVertex(Vertex *v);
 
     /**
      * Gets the vertexSet of the graph
      * Time Complexity: O(1)
-     * @return a map with all the vertexes of the graph.
+     * @return a reference to the vector with all the vertexes of the graph, indexed by id
+     */
+    const vector<Vertex *> &getVertexSet() const;
+
+    /**
+     * Gets the id a vertex had in the input files
+     * Complexity: O(1)
+     * @param id - the current id of the vertex
+     * @return the id of the vertex in the input files
      */
-    unordered_map<int, Vertex *> getVertexSet() const;
+    int getOriginalId(int id) const;
 
     /**
      * Adds a bidirectional edge to the graph between two vertexes with a given distance
@@ -66,11 +113,37 @@ public:
      */
     bool addBidirectionalEdge(Vertex * &v1, Vertex * &v2, double dist);
 
+    /**
+     * Changes the length of the bidirectional edge between two vertexes. The rows of the metric closure with a shortest
+     * path through the edge, before or after the change, are dropped, as are the distances of the pairs cached by the
+     * oracle. The Haversine distances of the pairs without an edge do not depend on it
+     * Time Complexity: O(1) on average, plus O(R) if the metric closure has R cached rows
+     * @param v1 - the first vertex
+     * @param v2 - the second vertex
+     * @param dist - the new length of the edge
+     * @return true if successful, false if there is no edge between the vertexes
+     */
+    bool setEdgeDistance(Vertex *v1, Vertex *v2, double dist);
+
     /**
      * Builds the minimum spanning tree of the graph using Prim's algorithm
      * Complexity: O(E*log(V)) where E is the number of edges and V the number of edges of the graph
+     * @param penalties - penalty of each vertex, added to the length of every edge of the vertex (empty for none)
+     * @param excluded - vertex left out of the tree, nullptr to span every vertex
+     */
+    void mstBuild(const vector<double> &penalties = vector<double>(), Vertex *excluded = nullptr);
+
+    /**
+     * Computes the Held-Karp lower bound of the length of any tour over the edges of the graph with subgradient
+     * optimization: each iteration builds a minimum 1-tree (see mstBuild) with vertex penalties and then raises the
+     * penalties of the vertexes with degree above 2 and lowers the ones of the leaves
+     * Complexity: O(I*E*log(V)) where I is the number of iterations, E the number of edges and V the number of vertexes
+     * @param upperBound - length of a known tour, used to size the penalty steps
+     * @param iterations - maximum number of iterations
+     * @param control - deadline and cancellation token, the best bound found so far is returned when stopped
+     * @return the lower bound, 0 if the edges do not connect every vertex
      */
-    void mstBuild();
+    double heldKarpBound(double upperBound, int iterations = 100, const SolveControl &control = SolveControl());
 
     /**
      * Depth first search on the graph, which defines the route for the 2-approximate tsp algorithm
@@ -99,12 +172,15 @@ public:
     double haversineCalculator(double lat1, double long1, double lat2, double long2);
 
     /**
-     * Calls the backtracking algorithm for the travelling salesman problem
+     * Calls the backtracking algorithm for the travelling salesman problem. Only edges of the graph are used, unless the
+     * metric closure mode is on, in which case vertexes without an edge between them are joined by their shortest path
      * Complexity: O(V!) being V the number of vertexes in the graph
      * @param path vector that keeps the vertexes in the order they were visited
+     * @param control deadline, cancellation token and progress callback. If the search is stopped early, the best tour
+     * found so far is returned
      * @return distance travelled in the backtracking algorithm for the travelling salesman problem
      */
-    double tspBT(vInt &path);
+    double tspBT(vInt &path, const SolveControl &control = SolveControl());
 
     /**
      * Recursive backtracking algorithm that gives the optimal solution to the traveling salesman problem
@@ -114,12 +190,16 @@ public:
      * @param currSum distance travelled through the vertexes that were visited
      * @param bestSum least distance travelled through all the vertexes until now
      * @param step number of vertexes that were already visited
+     * @param control deadline, cancellation token and progress callback
      * @return best distance travelled from all the sets that were already tried
      */
-    double tspBacktracking(vInt &path, int currVertexId, double currSum, double bestSum, uint step);
+    double tspBacktracking(vInt &path, int currVertexId, double currSum, double bestSum, uint step,
+                           const SolveControl &control);
 
     /**
-     * Computes the nearest neighbour route for the travelling salesman problem
+     * Computes the nearest neighbour route for the travelling salesman problem. In metric closure mode, the nearest
+     * unvisited vertex is chosen by shortest path distance. Otherwise, it is the nearest one through an edge or, if the
+     * current vertex has no edge towards an unvisited vertex, the nearest one by Haversine distance
      * Complexity: O(V^2 * E) where V is the number of vertexes and E the number of edges in the graph
      */
     double nearestNeighbourRouteTsp(vInt &path);
@@ -133,36 +213,62 @@ public:
     Vertex * findNearestHaversine(Vertex *currentV);
 
     /**
-     * Performs a swap in the 2-opt tour improvement algorithm
-     * Complexity: O(V) being V the number of vertexes in the graph
-     * @param path current order of the vertexes to compute the tsp distance
+     * Performs a swap in the 2-opt tour improvement algorithm, reversing the vertexes between i+1 and k in place
+     * Complexity: O(k-i)
+     * @param path current order of the vertexes to compute the tsp distance, reordered according to the swap
      * @param i index of the first vertex in path to be considered in the swap
      * @param k index of the second vertex in path to be considered in the swap
-     * @return updated reordered path according to the swap
      */
-    vInt twoOptSwap(vInt path, int i, int k);
+    void twoOptSwap(vInt &path, int i, int k);
 
     /**
      * Tour improvement algorithm to be ran after a solution has been found for the tsp problem
      * Complexity: the complexity of this algorithm isn't clear. However, the lower bound is Ω(E*V³) where V is the number
      * of vertexes and E the number of edges in the graph. The upper bound could be O(E*V³) as well, but a 2opt swap isn't
-     * guaranteed to not for a new intersection between edges
+     * guaranteed to not for a new intersection between edges. The tour is kept in a two-level list, so each swap costs
+     * O(sqrt(V)) instead of reversing part of the path
      * @param path tour considered in the algorithm that gave the solution to the tsp
      * @param bestDistance distance that comes from a previous heuristic to find the solution for the tsp
+     * @param control deadline, cancellation token and progress callback. If the search is stopped early, the path
+     * keeps every improvement applied so far
      * @return the lowest distance of the path obtained with this algorithm
      */
-    double twoOpt(vInt &path, double bestDistance);
+    double twoOpt(vInt &path, double bestDistance, const SolveControl &control = SolveControl());
 
     /**
-     * Computes the distance between two vertexes. If there is an edge between the vertexes, the length of the edge is used.
-     * Otherwise, the Haversine formula is used
-     * Complexity: O(E) where E is the number of edges in the graph
+     * Parallel 2-opt for large tours: in each round the threads evaluate the candidate moves of their segment of the
+     * tour, then the improving moves that do not overlap are applied together. The result is polished with the fast
+     * local search, which adds the Or-opt moves. The tour found is the same for any number of threads
+     * Complexity: O(V*E) to build the candidate lists, then O(A*K/T + V) per round, where A is the number of vertexes
+     * next to a changed edge, K the candidate list size and T the number of threads
+     * @param path tour computed by a previous heuristic, starting and ending at vertex 0, replaced by the improved tour
+     * @param distance distance of the tour in path
+     * @param control deadline, cancellation token and progress callback
+     * @param threads number of threads evaluating the moves, 0 to use one per core
+     * @return the distance of the improved tour
+     */
+    double parallelTwoOpt(vInt &path, double distance, const SolveControl &control = SolveControl(),
+                          unsigned threads = 0);
+
+    /**
+     * Computes the distance between two vertexes. In metric closure mode, the length of the shortest path between them
+     * is used. Otherwise, if there is an edge between the vertexes, the length of the edge is used. The Haversine
+     * formula is used as a fallback, when there is no edge (or no path) between the vertexes. Distances that are not
+     * edge lengths are kept in the LRU cache of the distance oracle
+     * Complexity: O(E) where E is the number of edges of v1, O(1) on average for cached pairs in metric closure mode
      * @param v1 the first vertex to be considered
      * @param v2 the second vertex to be considered
      * @return the distance between v1 and v2
      */
     double calculateTwoVerticesDist(Vertex *v1, Vertex *v2);
 
+    /**
+     * Gets the distance oracle that answers calculateTwoVerticesDist, to read the statistics of its cache
+     * Complexity: O(1)
+     * @return the distance oracle of the graph
+     */
+    DistanceOracle &getDistanceOracle() const;
+
     /**
      * Runs the christofides heuristic to solve the tsp problem. This version of the algorithm uses a greedy approach
      * instead of the blossom algorithm for the perfect matching step
@@ -206,11 +312,10 @@ public:
     /**
      * Merges an eulerian path into the current eulerian tour
      * Complexity: O(V) where V is the number of vertexes in the graph
-     * @param eulerianTour current eulerian tour
+     * @param eulerianTour current eulerian tour, updated in place with the recently found path merged into it
      * @param path eulerian path recently found
-     * @return updated eulerian tour with the recently found path merged into it
      */
-    vector<Vertex *> mergePath(vector<Vertex *> &eulerianTour, vector<Vertex *> path);
+    void mergePath(vector<Vertex *> &eulerianTour, const vector<Vertex *> &path);
 
     /**
      * Computes the distance that takes to traverse the eulerian tour
@@ -218,12 +323,261 @@ public:
      * @param eulerianTour order of the vertexes in the eulerian tour
      * @return total distance that was traversed
      */
-    double calculateChrisDistance(vector<Vertex *> eulerianTour);
+    double calculateChrisDistance(const vector<Vertex *> &eulerianTour);
+
+    /**
+     * Keeps the first occurrence of each vertex of an eulerian tour and closes the tour at vertex 0
+     * Complexity: O(V) where V is the number of vertexes in the tour
+     * @param path order of the vertexes in the eulerian tour
+     * @return the ids of the vertexes without repetitions, ending at vertex 0
+     */
+    vInt removeRepeatingVertexes(const vector<Vertex *> &path);
+
+    /**
+     * Sorts the vertexes by their index along a Hilbert space-filling curve laid over their latitude and longitude.
+     * Vertexes close on the curve are close on the map. Ties (e.g. graphs without coordinates) are broken by id
+     * Complexity: O(V*log(V)) where V is the number of vertexes in the graph
+     * @return the vertexes in curve order
+     */
+    vector<Vertex *> hilbertOrder() const;
+
+    /**
+     * Builds a tour that visits the vertexes in the order of the Hilbert curve, starting at vertex 0. It is a very fast
+     * but rough initial tour for the local search algorithms
+     * Complexity: O(V*log(V) + V*E) where V is the number of vertexes and E the number of edges of a vertex
+     * @param path vector that will be filled with the tour, starting and ending at vertex 0
+     * @return the distance of the tour
+     */
+    double hilbertCurveTsp(vInt &path);
+
+    /**
+     * Greedy edge heuristic: goes through every edge of the graph by increasing length and adds it to the tour if both
+     * endpoints have fewer than two tour edges and it does not close a cycle (checked with union-find). On incomplete
+     * graphs the resulting paths are then joined by their nearest endpoints
+     * Complexity: O(E*log(E) + F²*E) where E is the number of edges in the graph and F the number of paths left
+     * @param path vector that will be filled with the tour, starting and ending at vertex 0
+     * @return the distance of the tour
+     */
+    double greedyEdgeTsp(vInt &path);
+
+    /**
+     * Clarke-Wright savings heuristic with vertex 0 as the hub: goes through the edges of the graph (not incident to
+     * the hub) by decreasing saving d(0,i) + d(0,j) - d(i,j) and merges the routes of i and j when both are route
+     * endpoints. The remaining routes are joined by their nearest endpoints, starting and ending at the hub
+     * Complexity: O(E*log(E) + F²*E) where E is the number of edges in the graph and F the number of routes left
+     * @param path vector that will be filled with the tour, starting and ending at vertex 0
+     * @return the distance of the tour
+     */
+    double savingsTsp(vInt &path);
+
+    /**
+     * Insertion heuristic: starts with a tour between vertex 0 and its nearest (farthest, for farthest insertion)
+     * vertex and inserts the remaining vertexes one by one, each at the position that increases the tour the least.
+     * The vertex inserted next is the one with the cheapest insertion, the one farthest from the tour, or a random one.
+     * The best position of every vertex is cached and, after each insertion, only compared with the two new tour
+     * edges; it is recomputed from scratch only when its cached edge was the one removed and both new edges cost more.
+     * The distances come from the matrix or closure rows chosen by the distance policy when the graph allows it
+     * Complexity: O(V²) distance computations in practice, where V is the number of vertexes in the graph
+     * @param path vector that will be filled with the tour, starting and ending at vertex 0
+     * @param rule how the next vertex to insert is chosen
+     * @param seed seed of the random number generator, used by random insertion
+     * @return the distance of the tour
+     */
+    double insertionTsp(vInt &path, insertion_rule rule, unsigned seed = 0);
+
+    /**
+     * Renumbers the vertexes following the Hilbert curve order, keeping vertex 0 as 0, and sorts every adjacency
+     * vector by destination. Vertexes, edges and tours that are close in memory are then close on the map, which
+     * makes the algorithms more cache friendly. The previous ids are kept and can be read with getOriginalId
+     * Complexity: O(V*log(V) + E*log(E)) where V is the number of vertexes and E the number of edges in the graph
+     */
+    void spatialRenumber();
+
+    /**
+     * Turns the metric closure mode on or off. In this mode, the distance between two vertexes that are not connected by
+     * an edge is the length of the shortest path between them on the graph, instead of the straight line (Haversine)
+     * distance, so the tours of incomplete graphs have distances that can actually be travelled. The shortest paths are
+     * computed with Dijkstra's algorithm when first needed and cached per source vertex, which takes O(V²) memory if
+     * every row is used, unless maxRows is set. Turning the mode on again discards the cached distances
+     * Complexity: O(V)
+     * @param enabled whether the metric closure should be used
+     * @param maxRows maximum number of source vertexes whose distances are kept, 0 to keep them all
+     */
+    void setMetricClosure(bool enabled, size_t maxRows = 0);
+
+    /**
+     * Checks if the metric closure mode is on
+     * Complexity: O(1)
+     * @return true if distances between vertexes are shortest path distances, false otherwise
+     */
+    bool usesMetricClosure() const;
+
+    /**
+     * Gets the metric closure that answers the distances in the metric closure mode
+     * Complexity: O(1)
+     * @return the metric closure, nullptr if the metric closure mode is off
+     */
+    shared_ptr<MetricClosure> getMetricClosure() const;
+
+    /**
+     * Computes the shortest path distances from every vertex that was not used as a source yet, in parallel. Does
+     * nothing if the metric closure mode is off or cannot keep every row. Must not run at the same time as another solver on this graph
+     * Complexity: O(V*E*log(V)/T) where V is the number of vertexes, E the number of edges and T the number of threads
+     * @param threads number of threads, 0 to use one per core
+     */
+    void computeMetricClosure(unsigned threads = 0);
 
-    vInt removeRepeatingVertexes(vector<Vertex *> path);
+    /**
+     * Builds the edge index of every vertex, so that findEdge takes constant time. Called once the graph is loaded
+     * and after the vertexes are renumbered. The indexes take about as much memory as the edges and adjacency vectors
+     * (2.5 MB on graph2, 3.1 MB on graph3, 14.7 MB on the 900 vertex medium graph), and they are also built for
+     * incomplete graphs: without a metric closure every distance query of the local searches looks for an edge, and
+     * twoOpt takes 4.4 times longer on graph2 and 2.4 times longer on graph3 with the linear scan
+     * Complexity: O(V+E) where V is the number of vertexes and E the number of edges in the graph
+     */
+    void buildEdgeIndexes();
+
+    /**
+     * Checks if every pair of vertexes of the graph is connected by an edge
+     * Complexity: O(V) where V is the number of vertexes in the graph
+     * @return true if the graph is complete, false otherwise
+     */
+    bool isComplete() const;
+
+    /**
+     * Builds, for each city, the list of its k nearest cities, sorted by increasing distance. The edges of the graph are
+     * used when the city has at least k of them towards other cities, otherwise every city is considered with
+     * calculateTwoVerticesDist. With the metric closure every city is considered over the closure row of the city,
+     * computed if it is not cached, so only the rows of the listed cities are needed
+     * Complexity: O(n*E) where n is the number of cities and E the number of edges of a vertex, O(n²*E) if the graph is
+     * sparse
+     * @param cities the cities to be considered, a city is identified by its index in this vector
+     * @param k size of each list
+     * @param only indices of the cities whose lists are built, the others are left empty. Every city if empty
+     * @return the candidate list of each city
+     */
+    vector<vInt> buildCandidateLists(const vector<Vertex *> &cities, unsigned k, const vInt &only = vInt());
+
+    /**
+     * Iterated local search: alternates segment-limited double-bridge kicks with a fast 2-opt/Or-opt local search
+     * (candidate lists and don't look bits) around the kicked edges, keeping a kick only if it improves the tour.
+     * Runs until the control stops it, or for max(100, V) kicks if it has no deadline
+     * Complexity: O(V*E) to build the candidate lists, then O(V) per kick, since each kick loads the tour into the
+     * local search and copies it, plus O(K) distance computations per improving move in practice
+     * @param path tour computed by a previous heuristic, starting and ending at vertex 0, replaced by the improved tour
+     * @param distance distance of the tour in path
+     * @param control deadline, cancellation token and progress callback
+     * @param threads number of independent chains run in parallel, 0 to use one per core
+     * @param seed seed of the random number generator, chain i uses (seed, i)
+     * @return the distance of the best tour found
+     */
+    double iteratedLocalSearch(vInt &path, double distance, const SolveControl &control, unsigned threads = 1,
+                               unsigned seed = 0);
+
+    /**
+     * Simulated annealing over random 2-opt moves between candidate neighbours, with O(1) delta evaluation and a
+     * geometric cooling schedule spread over the time limit of the control (or 1000*V moves if it has no deadline).
+     * The best tour found is polished with the fast local search
+     * Complexity: O(V*E) to build the candidate lists, then O(M*V) in the worst case where M is the number of moves
+     * @param path tour computed by a previous heuristic, starting and ending at vertex 0, replaced by the improved tour
+     * @param distance distance of the tour in path
+     * @param control deadline, cancellation token and progress callback
+     * @param threads number of independent chains run in parallel, 0 to use one per core
+     * @param seed seed of the random number generator, chain i uses (seed, i)
+     * @return the distance of the best tour found
+     */
+    double simulatedAnnealing(vInt &path, double distance, const SolveControl &control, unsigned threads = 1,
+                              unsigned seed = 0);
+
+    /**
+     * Island-model genetic algorithm. Each island keeps a small population, seeded with the tour in path, the nearest
+     * neighbour tour and (on complete graphs) the Christofides tour, plus kicked variants of them. Islands evolve in
+     * parallel with tournament selection, order crossover (OX), occasional double-bridge mutation and the fast local
+     * search as repair step, and every few generations the best tour of each island migrates to the next one (ring).
+     * Runs until the control stops it, or for a fixed number of epochs if it has no deadline
+     * Complexity: O(V*E) to build the candidate lists and seeds, then O(V*K) per offspring in practice
+     * @param path tour computed by a previous heuristic, starting and ending at vertex 0, replaced by the best tour
+     * @param distance distance of the tour in path
+     * @param control deadline, cancellation token and progress callback
+     * @param islands number of islands, each evolved by its own thread, 0 to use one per core
+     * @param seed seed of the random number generator, island i uses (seed, i)
+     * @return the distance of the best tour found
+     */
+    double geneticAlgorithm(vInt &path, double distance, const SolveControl &control, unsigned islands = 0,
+                            unsigned seed = 0);
+
+    /**
+     * Partition and merge heuristic for large graphs: splits the vertexes by recursive bisection at the median latitude
+     * or longitude into clusters of at most clusterSize vertexes, builds a greedy edge tour of each cluster and improves
+     * it with the fast local search, with the clusters solved in parallel. The cluster tours are then chained in the
+     * order of their centroids along the Hilbert curve and a last local search pass starts only from the vertexes near
+     * the cluster borders. Graphs without coordinates are solved as a single cluster
+     * Complexity: O(V*E/T) to build the candidate lists of the clusters, where T is the number of threads, then O(V*E)
+     * for the global candidate lists and O(K) per improving move in practice
+     * @param path vector that will be filled with the tour, starting and ending at vertex 0
+     * @param control deadline and cancellation token, the local searches stop early when it stops them
+     * @param threads number of threads solving clusters, 0 to use one per core
+     * @param clusterSize maximum number of vertexes of a cluster
+     * @return the distance of the tour
+     */
+    double partitionTsp(vInt &path, const SolveControl &control = SolveControl(), unsigned threads = 0,
+                        unsigned clusterSize = 200);
+
+    /**
+     * Solves the tsp over a subset of the vertexes, using the distances of the graph (edges, Haversine or shortest
+     * paths) without building a new graph. The distances between the vertexes of the subset are computed once into a
+     * matrix, with the rows split between threads, then a greedy edge tour over the matrix is improved with iterated
+     * local search until the control stops it, or for max(100, n) kicks if it has no deadline
+     * Complexity: O(n²/T) distance computations, where n is the size of the subset and T the number of threads, plus
+     * O(n²*log(n)) for the greedy tour and candidate lists and O(n) per kick
+     * @param ids distinct ids of the vertexes to visit, the tour starts at the first one. Throws invalid_argument if
+     * an id is not a vertex of the graph or is repeated
+     * @param path vector that will be filled with the tour, starting and ending at ids[0]
+     * @param control deadline, cancellation token and progress callback
+     * @param threads number of threads computing the distances, 0 to use one per core
+     * @param seed seed of the random number generator of the kicks
+     * @return the distance of the tour
+     */
+    double subsetTsp(const vInt &ids, vInt &path, const SolveControl &control = SolveControl(), unsigned threads = 0,
+                     unsigned seed = 0);
+
+    /**
+     * Repairs a tour after a few stops were added or removed or a few edges changed length, instead of solving the
+     * graph again. Removed stops are skipped, each inserted vertex goes where it makes the tour the least longer, and
+     * the fast local search then starts only from the vertexes next to a change, with candidate lists built only
+     * around them. Vertexes added to the graph need buildEdgeIndexes, and setMetricClosure again if it is on
+     * Complexity: O(n) per inserted vertex, O(A*K*E) for the candidate lists, O(n) to load the tour into the local
+     * search and O(K) per improving move in practice, where n is the number of stops, A the number of changed vertexes
+     * and E the number of edges of a vertex
+     * @param path the previous tour, replaced by the repaired one, which starts and ends at the same vertex as before
+     * unless it was removed
+     * @param delta the changes since the tour was computed. Throws invalid_argument, leaving path unchanged, if a vertex
+     * of the tour or the delta is unknown, a removed vertex is not in the tour, an inserted vertex already is, or a
+     * changed pair of vertexes has no edge
+     * @param control deadline and cancellation token of the local search
+     * @return the distance of the repaired tour
+     */
+    double reoptimize(vInt &path, const TourDelta &delta, const SolveControl &control = SolveControl());
 
 protected:
-    std::unordered_map<int, Vertex *> vertexSet; /**< The map with all the vertexes of the graph */
+    /**
+     * Joins vertex-disjoint paths into a tour: starts at the path that contains vertex 0 and repeatedly moves to the
+     * nearest endpoint of a path that was not visited yet
+     * Complexity: O(V + F²*E) where V is the number of vertexes, F the number of paths and E the number of edges of a
+     * vertex
+     * @param cities the vertexes, identified by their index in this vector
+     * @param links the (up to two) neighbours of each city in its path, -1 if there is none
+     * @param path vector that will be filled with the tour, starting and ending at vertex 0
+     * @return the distance of the tour
+     */
+    double joinPathFragments(const vector<Vertex *> &cities, const vector<array<int, 2>> &links, vInt &path);
+
+    vector<Vertex *> vertexSet; /**< The vertexes of the graph, indexed by their dense id */
+    deque<Edge> edgeSet; /**< Every edge once, a deque so that adding edges does not move the others */
+    vInt originalIds; /**< Id each vertex had in the input files, indexed by its current id */
+    unordered_map<int, int> denseIds; /**< Current id of each vertex, indexed by its id in the input files */
+    shared_ptr<MetricClosure> closure; /**< Shortest path distances, nullptr if the metric closure mode is off */
+    shared_ptr<DistanceOracle> oracle = make_shared<DistanceOracle>(); /**< Answers calculateTwoVerticesDist */
 
 
 };
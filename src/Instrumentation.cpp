@@ -0,0 +1,127 @@
+#include "Instrumentation.h"
+#include <iomanip>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace {
+    const char *counterNames[Instrumentation::numCounters] = {
+            "findEdge calls",
+            "Haversine evaluations",
+            "2-opt moves evaluated",
+            "2-opt moves accepted",
+            "Heap inserts",
+            "Heap extractions",
+            "Heap decrease-keys",
+            "Shortest path searches",
+    };
+
+    /// Counters owned by one thread. Only the owner increments them, so no read-modify-write atomics are needed;
+    /// reset() also zeroes them, and a count made by a thread while reset() runs may be kept.
+    struct ThreadCounters {
+        atomic<unsigned long long> values[Instrumentation::numCounters];
+
+        ThreadCounters();
+
+        ~ThreadCounters();
+    };
+
+    /// Time accumulated by one stage.
+    struct StageTime {
+        string name;
+        unsigned long long calls;
+        double seconds;
+    };
+
+    mutex countersMutex;
+    vector<ThreadCounters *> liveCounters; /**< Counters of the threads that are still running */
+    unsigned long long retiredCounters[Instrumentation::numCounters] = {}; /**< Counts of threads that have finished */
+
+    mutex stagesMutex;
+    vector<StageTime> stageTimes; /**< Stages in the order they were first timed */
+
+    thread_local ThreadCounters threadCounters;
+
+    ThreadCounters::ThreadCounters() {
+        for (auto &value: values) value.store(0, memory_order_relaxed);
+        lock_guard<mutex> lock(countersMutex);
+        liveCounters.push_back(this);
+    }
+
+    ThreadCounters::~ThreadCounters() {
+        lock_guard<mutex> lock(countersMutex);
+        for (int c = 0; c < Instrumentation::numCounters; c++) {
+            retiredCounters[c] += values[c].load(memory_order_relaxed);
+        }
+        liveCounters.erase(find(liveCounters.begin(), liveCounters.end(), this));
+    }
+}
+
+Instrumentation::ScopedTimer::ScopedTimer(const char *stage) : stage(stage), start(chrono::steady_clock::now()) {}
+
+Instrumentation::ScopedTimer::~ScopedTimer() {
+    addTime(stage, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+}
+
+bool Instrumentation::enabled() {
+#ifdef TSP_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Instrumentation::count(counter c, unsigned long long n) {
+    auto &value = threadCounters.values[c];
+    value.store(value.load(memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+void Instrumentation::addTime(const char *stage, double seconds) {
+    lock_guard<mutex> lock(stagesMutex);
+    for (StageTime &s: stageTimes) {
+        if (s.name == stage) {
+            s.calls++;
+            s.seconds += seconds;
+            return;
+        }
+    }
+    stageTimes.push_back({stage, 1, seconds});
+}
+
+void Instrumentation::reset() {
+    {
+        lock_guard<mutex> lock(stagesMutex);
+        stageTimes.clear();
+    }
+    lock_guard<mutex> lock(countersMutex);
+    for (auto &value: retiredCounters) value = 0;
+    for (ThreadCounters *counters: liveCounters) {
+        for (auto &value: counters->values) value.store(0, memory_order_relaxed);
+    }
+}
+
+void Instrumentation::report(ostream &os) {
+    if (!enabled()) {
+        os << "Instrumentation disabled (configure with -DTSP_INSTRUMENTATION=ON)" << endl;
+        return;
+    }
+
+    auto flags = os.flags();
+    os << fixed << setprecision(3);
+    {
+        lock_guard<mutex> lock(stagesMutex);
+        os << left << setw(32) << "Stage" << right << setw(10) << "Calls" << setw(16) << "Total (ms)" << endl;
+        for (const StageTime &s: stageTimes) {
+            os << left << setw(32) << s.name << right << setw(10) << s.calls << setw(16) << s.seconds * 1000 << endl;
+        }
+    }
+
+    lock_guard<mutex> lock(countersMutex);
+    os << left << setw(32) << "Counter" << right << setw(26) << "Value" << endl;
+    for (int c = 0; c < numCounters; c++) {
+        unsigned long long total = retiredCounters[c];
+        for (ThreadCounters *counters: liveCounters) total += counters->values[c].load(memory_order_relaxed);
+        os << left << setw(32) << counterNames[c] << right << setw(26) << total << endl;
+    }
+    os.flags(flags);
+}
@@ -0,0 +1,98 @@
+#ifndef PROJECT_TSP_INSTRUMENTATION_H
+#define PROJECT_TSP_INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/**
+ * Lightweight per-stage timers and event counters for the solvers.
+ * The INSTRUMENT_* macros below compile to nothing unless TSP_INSTRUMENTATION is defined
+ * (cmake -DTSP_INSTRUMENTATION=ON), so release builds pay no cost for them.
+ */
+class Instrumentation {
+public:
+
+    /// Events counted by the instrumentation layer.
+    enum counter {
+        findEdgeCalls,
+        haversineEvaluations,
+        twoOptMovesEvaluated,
+        twoOptMovesAccepted,
+        heapInserts,
+        heapExtractions,
+        heapDecreaseKeys,
+        shortestPathSearches,
+        numCounters
+    };
+
+    /// Measures the wall time between its construction and destruction and adds it to a stage.
+    class ScopedTimer {
+    public:
+        /**
+         * Starts timing a stage
+         * @param stage - name of the stage, must outlive the timer (string literals are used)
+         */
+        explicit ScopedTimer(const char *stage);
+
+        /**
+         * Stops timing and adds the elapsed time to the stage
+         */
+        ~ScopedTimer();
+
+    private:
+        const char *stage; /**< Name of the stage being timed */
+        chrono::steady_clock::time_point start; /**< Time at which the timer was created */
+    };
+
+    /**
+     * Checks if the instrumentation was compiled in
+     * @return true if TSP_INSTRUMENTATION is defined, false otherwise
+     */
+    static bool enabled();
+
+    /**
+     * Adds n occurrences to a counter of the calling thread
+     * Complexity: O(1)
+     * @param c - the counter to be incremented
+     * @param n - number of occurrences
+     */
+    static void count(counter c, unsigned long long n = 1);
+
+    /**
+     * Adds a measured time to a stage
+     * Complexity: O(S) where S is the number of different stages
+     * @param stage - name of the stage
+     * @param seconds - elapsed time
+     */
+    static void addTime(const char *stage, double seconds);
+
+    /**
+     * Clears every stage time and counter. Call it while no other thread counts events, or some of their counts
+     * may be kept
+     * Complexity: O(S+T) where S is the number of stages and T the number of threads that counted events
+     */
+    static void reset();
+
+    /**
+     * Prints the time spent in each stage and the value of each counter
+     * Complexity: O(S+T) where S is the number of stages and T the number of threads that counted events
+     * @param os - the stream to print to
+     */
+    static void report(ostream &os);
+};
+
+#ifdef TSP_INSTRUMENTATION
+#define INSTRUMENT_SCOPE(stage) Instrumentation::ScopedTimer instrumentationTimer(stage)
+#define INSTRUMENT_COUNT(c) Instrumentation::count(Instrumentation::c)
+#define INSTRUMENT_ADD(c, n) Instrumentation::count(Instrumentation::c, n)
+#else
+#define INSTRUMENT_SCOPE(stage) ((void) 0)
+#define INSTRUMENT_COUNT(c) ((void) 0)
+#define INSTRUMENT_ADD(c, n) ((void) 0)
+#endif
+
+#endif //PROJECT_TSP_INSTRUMENTATION_H
@@ -0,0 +1,506 @@
+#ifndef PROJECT_TSP_LOCALSEARCH_H
+#define PROJECT_TSP_LOCALSEARCH_H
+
+#include <vector>
+#include <deque>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <thread>
+#include "Instrumentation.h"
+#include "Random.h"
+#include "SolveControl.h"
+#include "TwoLevelList.h"
+
+using namespace std;
+
+/**
+ * Fast local search (2-opt and Or-opt moves restricted to candidate lists, with don't look bits). Tours are passed as
+ * arrays of city indices but searched on a two-level list, so every move is evaluated in O(1) distance computations
+ * and applied in O(sqrt(n)) time instead of reversing up to half of the array.
+ * class Dist must have: double operator()(int a, int b) const, returning the distance between two city indices.
+ */
+template <class Dist>
+class LocalSearch {
+public:
+    /**
+     * Constructor for the LocalSearch class
+     * @param dist - distance between two city indices, must outlive the local search
+     * @param candidates - for each city, its nearest cities sorted by increasing distance, must outlive the local search
+     */
+    LocalSearch(const Dist &dist, const vector<vector<int>> &candidates);
+
+    /**
+     * Applies improving moves until no city can be improved
+     * Complexity: O(n + I*(K + sqrt(n))), where I is the number of improving moves, K the candidate list size and n
+     * the number of cities
+     * @param tour - the tour, as a permutation of the city indices, updated in place
+     * @param length - current length of the tour
+     * @param control - deadline and cancellation token
+     * @return the length of the improved tour
+     */
+    double optimize(vector<int> &tour, double length, const SolveControl &control);
+
+    /**
+     * Applies improving moves, starting only from the given cities (the others have their don't look bit set)
+     * Complexity: O(n) to load the tour, then usually O(K) per active city, O(I*(K + sqrt(n))) in the worst case
+     * @param tour - the tour, as a permutation of the city indices, updated in place
+     * @param length - current length of the tour
+     * @param active - the cities the search starts from
+     * @param control - deadline and cancellation token
+     * @return the length of the improved tour
+     */
+    double optimize(vector<int> &tour, double length, const vector<int> &active, const SolveControl &control);
+
+    /**
+     * Applies a random segment-limited double-bridge kick to the tour
+     * Complexity: O(L) where L is the maximum segment length
+     * @param tour - the tour to be perturbed, with at least 8 cities
+     * @param length - current length of the tour
+     * @param rng - random number generator
+     * @param touched - filled with the endpoints of the changed edges
+     * @return the length of the perturbed tour
+     */
+    double doubleBridge(vector<int> &tour, double length, mt19937 &rng, vector<int> &touched) const;
+
+    /**
+     * Simulated annealing over random 2-opt moves between a city and one of its candidates, with a geometric cooling
+     * schedule spread over the time left in the control (or over maxMoves moves if there is no deadline)
+     * Complexity: O(M*sqrt(n)), plus O(n) each time the search leaves the best tour, where M is the number of moves and
+     * n the number of cities
+     * @param tour - the tour, replaced by the best tour found
+     * @param length - current length of the tour
+     * @param rng - random number generator
+     * @param maxMoves - number of moves to try when the control has no deadline
+     * @param control - deadline, cancellation token and progress callback
+     * @return the length of the best tour found
+     */
+    double anneal(vector<int> &tour, double length, mt19937 &rng, unsigned long maxMoves, const SolveControl &control);
+
+    /**
+     * 2-opt in rounds for large tours. In each round the cities next to an edge changed by the previous round look for
+     * their best improving move with a candidate, with the tour split into one segment per thread, then the moves that
+     * do not overlap are applied together, best first. Moves are chosen by their gain and position only, so the tour
+     * found does not depend on the number of threads. The first city of the tour never moves
+     * Complexity: O(A*K/T + n) per round, where A is the number of cities searched in the round, K the candidate list
+     * size, T the number of threads and n the number of cities
+     * @param tour - the tour, as a permutation of the city indices, updated in place
+     * @param length - current length of the tour
+     * @param threads - number of threads evaluating the moves, 0 to use one per core
+     * @param control - deadline, cancellation token and progress callback
+     * @return the length of the improved tour
+     */
+    double parallelTwoOpt(vector<int> &tour, double length, unsigned threads, const SolveControl &control) const;
+
+    /**
+     * Computes the length of a closed tour
+     * Complexity: O(n) where n is the number of cities
+     * @param dist - distance between two city indices
+     * @param tour - the tour
+     * @return the length of the tour
+     */
+    static double tourLength(const Dist &dist, const vector<int> &tour);
+
+private:
+    const Dist &dist; /**< Distance between two city indices */
+    const vector<vector<int>> &candidates; /**< Nearest cities of each city */
+    int n = 0; /**< Number of cities in the tour being optimized */
+    TwoLevelList order; /**< The tour being optimized */
+    vector<char> dontLook; /**< Don't look bit of each city */
+    deque<int> queue; /**< Cities whose don't look bit is cleared */
+
+    int next(int city) const { return order.next(city); }
+
+    int prev(int city) const { return order.prev(city); }
+
+    /**
+     * Clears the don't look bit of a city and queues it
+     * @param city - the city
+     */
+    void activate(int city);
+
+    /**
+     * Replaces the edges (a, b) and (c, d) by (a, c) and (b, d), where b and d follow a and c in the same direction
+     * (both next or both prev), by reversing one of the two paths between them
+     * Complexity: O(sqrt(n)) amortized, where n is the number of cities
+     * @param a - the first city of the first edge
+     * @param b - the second city of the first edge
+     * @param c - the first city of the second edge
+     * @param d - the second city of the second edge
+     */
+    void twoOptMove(int a, int b, int c, int d);
+
+    /**
+     * Tries every 2-opt move that adds an edge between a city and one of its candidates, applying the first improving one
+     * Complexity: O(K) distance computations, plus O(sqrt(n)) for the reversal
+     * @param a - the city
+     * @param length - current length of the tour, updated if a move is applied
+     * @return true if a move was applied, false otherwise
+     */
+    bool improveTwoOpt(int a, double &length);
+
+    /**
+     * Tries to move the segment of 1 to 3 cities starting at a next to one of the candidates of its endpoints,
+     * applying the first improving move
+     * Complexity: O(K) distance computations, plus O(sqrt(n)) for the reversals
+     * @param a - the first city of the segment
+     * @param length - current length of the tour, updated if a move is applied
+     * @return true if a move was applied, false otherwise
+     */
+    bool improveOrOpt(int a, double &length);
+
+    /**
+     * Moves the segment s1..s2 between e1 and e2 = next(e1), as a sequence of 2-opt moves
+     * Complexity: O(sqrt(n)) amortized, where n is the number of cities
+     * @param s1 - first city of the segment
+     * @param s2 - last city of the segment
+     * @param e1 - the city that precedes the segment after the move
+     * @param e2 - the city that follows the segment after the move
+     * @param reversed - if true the segment ends up as e1 s2..s1 e2, otherwise as e1 s1..s2 e2
+     */
+    void moveSegment(int s1, int s2, int e1, int e2, bool reversed);
+};
+
+namespace {
+    const double improvementEpsilon = 1e-7; /**< Minimum gain for a move to be considered improving */
+}
+
+template <class Dist>
+LocalSearch<Dist>::LocalSearch(const Dist &dist, const vector<vector<int>> &candidates)
+        : dist(dist), candidates(candidates) {}
+
+template <class Dist>
+double LocalSearch<Dist>::tourLength(const Dist &dist, const vector<int> &tour) {
+    double length = 0;
+    for (size_t i = 0; i < tour.size(); i++)
+        length += dist(tour[i], tour[i + 1 == tour.size() ? 0 : i + 1]);
+    return length;
+}
+
+template <class Dist>
+double LocalSearch<Dist>::optimize(vector<int> &tour, double length, const SolveControl &control) {
+    return optimize(tour, length, tour, control);
+}
+
+template <class Dist>
+double LocalSearch<Dist>::optimize(vector<int> &tour, double length, const vector<int> &active,
+                                   const SolveControl &control) {
+    n = (int) tour.size();
+    if (n < 5) return length;
+
+    order.assign(tour);
+    dontLook.assign(n, 1);
+    queue.clear();
+    for (int city: active) activate(city);
+
+    unsigned long steps = 0;
+    while (!queue.empty()) {
+        if ((++steps & 255) == 0 && control.shouldStop()) break;
+
+        int a = queue.front();
+        queue.pop_front();
+        dontLook[a] = 1;
+
+        if (improveTwoOpt(a, length) || improveOrOpt(a, length))
+            activate(a);
+    }
+
+    order.copyTo(tour, tour[0]);
+    return length;
+}
+
+template <class Dist>
+void LocalSearch<Dist>::activate(int city) {
+    if (dontLook[city]) {
+        dontLook[city] = 0;
+        queue.push_back(city);
+    }
+}
+
+template <class Dist>
+void LocalSearch<Dist>::twoOptMove(int a, int b, int c, int d) {
+    if (next(a) == b) order.flip(b, c);
+    else order.flip(a, d);
+}
+
+template <class Dist>
+bool LocalSearch<Dist>::improveTwoOpt(int a, double &length) {
+    for (int succ = 1; succ >= 0; succ--) {
+        int b = succ ? next(a) : prev(a);
+        double dab = dist(a, b);
+
+        for (int c: candidates[a]) {
+            double dac = dist(a, c);
+            if (dac >= dab) break;
+
+            int d = succ ? next(c) : prev(c);
+            if (c == b || d == a) continue;
+
+            INSTRUMENT_COUNT(twoOptMovesEvaluated);
+            double delta = dac + dist(b, d) - dab - dist(c, d);
+            if (delta < -improvementEpsilon) {
+                INSTRUMENT_COUNT(twoOptMovesAccepted);
+                twoOptMove(a, b, c, d);
+                length += delta;
+                activate(b);
+                activate(c);
+                activate(d);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+template <class Dist>
+bool LocalSearch<Dist>::improveOrOpt(int a, double &length) {
+    int s1 = a, s2 = a;
+    for (int segmentLength = 1; segmentLength <= 3 && segmentLength + 3 <= n; segmentLength++) {
+        if (segmentLength > 1) s2 = next(s2);
+        int p = prev(s1), nx = next(s2);
+        double removeGain = dist(p, s1) + dist(s2, nx) - dist(p, nx);
+        if (removeGain <= improvementEpsilon) continue;
+
+        for (int end = 0; end < 2; end++) {
+            int s = end == 0 ? s1 : s2;
+            for (int c: candidates[s]) {
+                double dsc = dist(s, c);
+                if (dsc >= removeGain) break;
+
+                // c must lie outside the segment
+                if (order.between(s1, c, s2)) continue;
+
+                for (int side = 0; side < 2; side++) {
+                    int e1 = side == 0 ? c : prev(c);
+                    int e2 = side == 0 ? next(c) : c;
+                    if (e1 == s2 || e2 == s1) continue;
+
+                    // s is attached to c, the other endpoint to the other city of the edge
+                    int other = s == s1 ? s2 : s1;
+                    int otherCity = side == 0 ? e2 : e1;
+                    double delta = dsc + dist(other, otherCity) - dist(e1, e2) - removeGain;
+                    if (delta < -improvementEpsilon) {
+                        // the segment ends up as e1 s1..s2 e2 when s1 is attached to e1
+                        bool reversed = (side == 0) != (s == s1);
+                        moveSegment(s1, s2, e1, e2, reversed);
+                        length += delta;
+                        activate(p);
+                        activate(nx);
+                        activate(e1);
+                        activate(e2);
+                        activate(s1);
+                        activate(s2);
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+template <class Dist>
+void LocalSearch<Dist>::moveSegment(int s1, int s2, int e1, int e2, bool reversed) {
+    int p = prev(s1), nx = next(s2);
+    // p [s1..s2] [nx..e1] e2  ->  p [e1..nx] [s2..s1] e2  ->  p [nx..e1] [s2..s1] e2
+    twoOptMove(p, s1, e1, e2);
+    twoOptMove(p, e1, nx, s2);
+    if (!reversed) twoOptMove(e1, s2, s1, e2);
+}
+
+template <class Dist>
+double LocalSearch<Dist>::anneal(vector<int> &tour, double length, mt19937 &rng, unsigned long maxMoves,
+                                 const SolveControl &control) {
+    n = (int) tour.size();
+    if (n < 5) return length;
+    order.assign(tour);
+
+    // Initial temperature: average uphill delta, so about a third of the uphill moves are accepted at the start
+    double uphill = 0;
+    int samples = 0;
+    for (int i = 0; i < 1000; i++) {
+        int a = uniformInt(rng, 0, n - 1), b = next(a);
+        int c = candidates[a][uniformInt(rng, 0, (int) candidates[a].size() - 1)];
+        int d = next(c);
+        double delta = dist(a, c) + dist(b, d) - dist(a, b) - dist(c, d);
+        if (c != b && d != a && delta > 0) {
+            uphill += delta;
+            samples++;
+        }
+    }
+    double startTemperature = samples > 0 ? uphill / samples : 1;
+    double endTemperature = startTemperature * 1e-3;
+    double temperature = startTemperature;
+
+    double budget = control.remainingSeconds();
+    auto start = chrono::steady_clock::now();
+
+    vector<int> best = tour;
+    double bestLength = length, reportedLength = length;
+    bool atBest = true; // the current tour is the best one, but has not been copied to best yet
+
+    for (unsigned long move = 0;; move++) {
+        if ((move & 1023) == 0) {
+            double progress = budget > 0 ? chrono::duration<double>(chrono::steady_clock::now() - start).count() / budget
+                                         : (double) move / maxMoves;
+            if (progress >= 1 || control.shouldStop()) break;
+            temperature = startTemperature * pow(endTemperature / startTemperature, progress);
+            if (bestLength < reportedLength) {
+                control.reportProgress(bestLength);
+                reportedLength = bestLength;
+            }
+        }
+
+        int a = uniformInt(rng, 0, n - 1), b = next(a);
+        const vector<int> &near = candidates[a];
+        if (near.empty()) continue;
+        int c = near[uniformInt(rng, 0, (int) near.size() - 1)];
+        int d = next(c);
+        if (c == b || d == a) continue;
+
+        INSTRUMENT_COUNT(twoOptMovesEvaluated);
+        double delta = dist(a, c) + dist(b, d) - dist(a, b) - dist(c, d);
+        if (delta < 0 || uniformReal(rng) < exp(-delta / temperature)) {
+            INSTRUMENT_COUNT(twoOptMovesAccepted);
+            if (delta > 0 && atBest) {
+                order.copyTo(best, tour[0]);
+                atBest = false;
+            }
+            order.flip(b, c);
+            length += delta;
+            if (length < bestLength - improvementEpsilon) {
+                bestLength = length;
+                atBest = true;
+            }
+        }
+    }
+
+    if (atBest) order.copyTo(tour, tour[0]);
+    else tour = best;
+    return bestLength;
+}
+
+template <class Dist>
+double LocalSearch<Dist>::parallelTwoOpt(vector<int> &tour, double length, unsigned threads,
+                                         const SolveControl &control) const {
+    /// 2-opt move found by city, that replaces the edges leaving positions first and second by reversing
+    /// tour[first + 1..second].
+    struct Move {
+        double delta;
+        int first, second, city;
+
+        bool operator<(const Move &other) const {
+            if (delta != other.delta) return delta < other.delta;
+            if (first != other.first) return first < other.first;
+            if (second != other.second) return second < other.second;
+            return city < other.city;
+        }
+    };
+
+    int size = (int) tour.size();
+    if (size < 5) return length;
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+
+    vector<int> position(size);
+    for (int i = 0; i < size; i++) position[tour[i]] = i;
+    vector<char> active(size, 1);
+    vector<Move> best(size);
+
+    while (!control.shouldStop()) {
+        // Evaluation: each thread searches the cities of its segment of the tour, reading the tour only
+        auto evaluate = [&](int from, int to) {
+            for (int p = from; p < to; p++) {
+                int a = tour[p];
+                best[p] = {0, 0, 0, a};
+                if (!active[a]) continue;
+
+                for (int succ = 1; succ >= 0; succ--) {
+                    int ea = succ ? p : (p + size - 1) % size;
+                    int b = tour[succ ? (p + 1) % size : ea];
+                    double dab = dist(a, b);
+
+                    for (int c: candidates[a]) {
+                        double dac = dist(a, c);
+                        if (dac >= dab) break;
+
+                        int ec = succ ? position[c] : (position[c] + size - 1) % size;
+                        int d = tour[succ ? (ec + 1) % size : ec];
+                        if (c == b || d == a) continue;
+
+                        INSTRUMENT_COUNT(twoOptMovesEvaluated);
+                        double delta = dac + dist(b, d) - dab - dist(c, d);
+                        if (delta < -improvementEpsilon && delta < best[p].delta)
+                            best[p] = {delta, min(ea, ec), max(ea, ec), a};
+                    }
+                }
+            }
+        };
+
+        int activeCities = (int) count(active.begin(), active.end(), 1);
+        // Small rounds are not worth starting threads, the moves found are the same either way
+        int workers = (int) min<long>(threads, activeCities / 1024 + 1);
+        int segment = (size + workers - 1) / workers;
+        vector<thread> pool;
+        for (int w = 1; w < workers; w++)
+            pool.emplace_back(evaluate, w * segment, min(size, (w + 1) * segment));
+        evaluate(0, min(size, segment));
+        for (thread &worker: pool)
+            worker.join();
+
+        // Selection: best moves first, a move is kept if the positions it changes do not overlap a kept move. Moves
+        // may share the city between their ranges, since neither of them moves it. The cities whose move was left out
+        // search again in the next round
+        vector<Move> moves;
+        for (const Move &move: best) {
+            if (move.delta < 0) moves.push_back(move);
+        }
+        if (moves.empty()) break;
+        sort(moves.begin(), moves.end());
+
+        map<int, int> taken;
+        fill(active.begin(), active.end(), 0);
+        for (const Move &move: moves) {
+            int lo = move.first, hi = move.second + 1;
+            auto after = taken.upper_bound(lo);
+            if ((after != taken.end() && after->first < hi) || (after != taken.begin() && std::prev(after)->second > lo)) {
+                active[move.city] = 1;
+                continue;
+            }
+            taken.emplace(lo, hi);
+
+            INSTRUMENT_COUNT(twoOptMovesAccepted);
+            int ends[] = {tour[lo], tour[lo + 1], tour[hi - 1], tour[hi % size]};
+            reverse(tour.begin() + lo + 1, tour.begin() + hi);
+            for (int i = lo + 1; i < hi; i++) position[tour[i]] = i;
+            for (int city: ends) active[city] = 1;
+            length += move.delta;
+        }
+        control.reportProgress(length);
+    }
+
+    return length;
+}
+
+template <class Dist>
+double LocalSearch<Dist>::doubleBridge(vector<int> &tour, double length, mt19937 &rng, vector<int> &touched) const {
+    int size = (int) tour.size();
+    int maxSegment = max(1, min(50, (size - 2) / 3));
+    int p1 = uniformInt(rng, 1, size - 2 * maxSegment - 1);
+    int p2 = p1 + uniformInt(rng, 1, maxSegment);
+    int p3 = p2 + uniformInt(rng, 1, maxSegment);
+
+    // A B C D -> A C B D, only the range [p1, p3) changes
+    int a1 = tour[p1 - 1], b1 = tour[p1], b2 = tour[p2 - 1], c1 = tour[p2], c2 = tour[p3 - 1], d1 = tour[p3];
+    length += dist(a1, c1) + dist(c2, b1) + dist(b2, d1) - dist(a1, b1) - dist(b2, c1) - dist(c2, d1);
+
+    vector<int> middle(tour.begin() + p2, tour.begin() + p3);
+    middle.insert(middle.end(), tour.begin() + p1, tour.begin() + p2);
+    copy(middle.begin(), middle.end(), tour.begin() + p1);
+
+    touched = {a1, b1, b2, c1, c2, d1};
+    return length;
+}
+
+#endif //PROJECT_TSP_LOCALSEARCH_H
@@ -48,7 +48,7 @@ void Menu::drawMenu() {
 }
 
 void Menu::drawMainMenu() {
-    loadedGraph = Graph();
+    loadedGraph = make_unique<Graph>();
 
     cout << "Choose which graph to load:" << endl;
     cout << "1 - Toy Graphs" << endl;
@@ -74,7 +74,7 @@ void Menu::drawMainMenu() {
 }
 
 void Menu::drawSpecificGraphs() {
-    loadedGraph = Graph();
+    loadedGraph = make_unique<Graph>();
     complete = true;
     switch (stoi(group)) {
         case 1:
@@ -260,25 +260,48 @@ bool Menu::loadGraph(int group, string graph) {
             }
             break;
     }
-    Scraper::scrape_graph(filename, loadedGraph, type);
-    gh = &loadedGraph;
+    Scraper::scrape_graph(filename, *loadedGraph, type);
+    if (type == Scraper::real) {
+        loadedGraph->spatialRenumber();
+    }
+    gh = loadedGraph.get();
     return true;
 }
 
 void Menu::drawChooseAlgorithm() {
     string option;
     int optionNumber = 1;
-    bool offset = false;
+    vInt algorithms = {0}; /**< Algorithm run by each option number */
 
     cout << "Choose which algorithm to run:" << endl;
     if (group == to_string(1)) {
         cout << optionNumber++ << " - Backtracking" << endl;
+        algorithms.push_back(1);
     }
     cout << optionNumber++ << " - Triangular Approximation" << endl;
+    algorithms.push_back(2);
     cout << optionNumber++ << " - Nearest Neighbor" << endl;
+    algorithms.push_back(3);
     if (complete) {
         cout << optionNumber++ << " - Christofides' Algorithm" << endl;
+        algorithms.push_back(4);
     }
+    cout << optionNumber++ << " - Hilbert Curve" << endl;
+    algorithms.push_back(5);
+    cout << optionNumber++ << " - Greedy Edge" << endl;
+    algorithms.push_back(6);
+    cout << optionNumber++ << " - Clarke-Wright Savings" << endl;
+    algorithms.push_back(7);
+    cout << optionNumber++ << " - Cheapest Insertion" << endl;
+    algorithms.push_back(8);
+    cout << optionNumber++ << " - Farthest Insertion" << endl;
+    algorithms.push_back(9);
+    cout << optionNumber++ << " - Random Insertion" << endl;
+    algorithms.push_back(10);
+    cout << optionNumber++ << " - Partition and Merge" << endl;
+    algorithms.push_back(11);
+    cout << optionNumber++ << " - Load Tour From File" << endl;
+    algorithms.push_back(12);
     cout << "b - Back" << endl;
     cout << "q - Quit" << endl;
 
@@ -301,16 +324,37 @@ void Menu::drawChooseAlgorithm() {
         drawMenu();
     }
 
-    if (group != to_string(1)) {
-        offset = true;
+    int algorithm = algorithms[stoi(option)];
+    SolveControl control;
+    if (algorithm == 1) {
+        control = getSolveControl();
+    }
+    string tourFile;
+    if (algorithm == 12) {
+        cout << "Name of the tour file (.csv, .json, .geojson or .bin):" << endl << ">> ";
+        getline(cin, tourFile);
+    }
+
+    if (!complete) {
+        string closure;
+        cout << "This graph is not complete. Use the shortest paths on the graph for the missing edges instead of"
+             << " straight lines? (type 'y' or 'Y')" << endl << ">> ";
+        getline(cin, closure);
+        // Creating the closure again would throw away the rows cached by the previous solves
+        bool useClosure = closure == "y" || closure == "Y";
+        if (useClosure != gh->usesMetricClosure()) gh->setMetricClosure(useClosure);
     }
 
     vInt path(gh->getVertexSet().size());
+    Instrumentation::reset();
+    gh->getDistanceOracle().resetStatistics();
     auto start = chrono::high_resolution_clock::now();
-    double distance;
-    switch (offset ? stoi(option) + 1: stoi(option)) {
+    double distance = 0;
+    switch (algorithm) {
         case 1:
-            distance = gh->tspBT(path);
+            distance = gh->tspBT(path, control);
+            cout << endl;
+            if (control.wasStopped()) cout << "Time limit reached, showing the best tour found so far" << endl;
             cout << "Total distance: " << distance << endl;
             break;
 
@@ -330,6 +374,52 @@ void Menu::drawChooseAlgorithm() {
 
             break;
 
+        case 5:
+            distance = gh->hilbertCurveTsp(path);
+            cout << "Total distance: " << distance << endl;
+            break;
+
+        case 6:
+            distance = gh->greedyEdgeTsp(path);
+            cout << "Total distance: " << distance << endl;
+            break;
+
+        case 7:
+            distance = gh->savingsTsp(path);
+            cout << "Total distance: " << distance << endl;
+            break;
+
+        case 8:
+            distance = gh->insertionTsp(path, Graph::cheapest_insertion);
+            cout << "Total distance: " << distance << endl;
+            break;
+
+        case 9:
+            distance = gh->insertionTsp(path, Graph::farthest_insertion);
+            cout << "Total distance: " << distance << endl;
+            break;
+
+        case 10:
+            distance = gh->insertionTsp(path, Graph::random_insertion);
+            cout << "Total distance: " << distance << endl;
+            break;
+
+        case 11:
+            distance = gh->partitionTsp(path);
+            cout << "Total distance: " << distance << endl;
+            break;
+
+        case 12:
+            try {
+                distance = TourIO::readTourFile(tourFile, *gh, path);
+            } catch (invalid_argument &e) {
+                cout << "Could not load the tour: " << e.what() << endl;
+                drawMenu();
+                return;
+            }
+            cout << "Total distance: " << distance << endl;
+            break;
+
         default:
             break;
     }
@@ -344,17 +434,72 @@ void Menu::drawChooseAlgorithm() {
         getline(cin, yn);
 
         if (yn == "y" || yn == "Y") {
+            string method;
+            cout << "Choose which optimization to run:" << endl
+                 << "1 - 2-opt" << endl
+                 << "2 - Iterated Local Search" << endl
+                 << "3 - Simulated Annealing" << endl
+                 << "4 - Genetic Algorithm" << endl
+                 << "5 - Parallel 2-opt" << endl
+                 << ">> ";
+            getline(cin, method);
+
+            control = getSolveControl();
             system("clear");
             cout << "Optimizing path..." << endl;
             start = chrono::high_resolution_clock::now();
-            double twoOptDistance = gh->twoOpt(path, distance);
+            double twoOptDistance;
+            if (method == "2") twoOptDistance = gh->iteratedLocalSearch(path, distance, control, 0);
+            else if (method == "3") twoOptDistance = gh->simulatedAnnealing(path, distance, control, 0);
+            else if (method == "4") twoOptDistance = gh->geneticAlgorithm(path, distance, control, 0);
+            else if (method == "5") twoOptDistance = gh->parallelTwoOpt(path, distance, control, 0);
+            else twoOptDistance = gh->twoOpt(path, distance, control);
+            cout << endl;
+            if (control.wasStopped()) cout << "Time limit reached, showing the best tour found so far" << endl;
             cout << "Total improved distance: " << twoOptDistance << "m" << endl;
             cout << "Improvement: " << (distance - twoOptDistance) / distance * 100 << "%" << endl;
             finish = chrono::high_resolution_clock::now();
             elapsed += finish - start;
+            distance = twoOptDistance;
         }
     }
     cout << "Elapsed time: " << elapsed.count() << " s\n";
+
+    // The bound only holds for tours over the edges of the graph
+    string boundYn;
+    if (complete && distance > 0) {
+        cout << "Compute a Held-Karp lower bound to compare the tour with? (type 'y' or 'Y')" << endl
+             << "WARNING: This may take up to 10 seconds!" << endl << ">> ";
+        getline(cin, boundYn);
+    }
+    if (boundYn == "y" || boundYn == "Y") {
+        SolveControl boundControl;
+        boundControl.setTimeLimit(10);
+        double bound = gh->heldKarpBound(distance, 100, boundControl);
+        if (bound > 0) {
+            cout << "Held-Karp lower bound: " << bound << "m (the tour is at most "
+                 << (distance - bound) / bound * 100 << "% longer than the optimal tour)" << endl;
+        }
+    }
+    DistanceOracle::Statistics cache = gh->getDistanceOracle().statistics();
+    if (cache.hits + cache.misses > 0) gh->getDistanceOracle().report(cout);
+    if (Instrumentation::enabled()) {
+        cout << endl;
+        Instrumentation::report(cout);
+    }
+
+    string exportFile;
+    cout << "Save the tour to a file? Type a name ending in .csv, .json, .geojson or .bin (press enter to skip)" << endl
+         << ">> ";
+    getline(cin, exportFile);
+    if (!exportFile.empty()) {
+        try {
+            TourIO::writeTourFile(exportFile, *gh, path, distance);
+            cout << "Tour saved to " << exportFile << endl;
+        } catch (invalid_argument &e) {
+            cout << "Could not save the tour: " << e.what() << endl;
+        }
+    }
     string dummy;
     cout << "Press anything to continue...\n";
     getline(cin, dummy);
@@ -364,3 +509,22 @@ void Menu::drawChooseAlgorithm() {
     drawMenu();
 }
 
+
+SolveControl Menu::getSolveControl() {
+    SolveControl control;
+    string limit;
+
+    cout << "Time limit in seconds (press enter for no limit):" << endl << ">> ";
+    getline(cin, limit);
+
+    try {
+        if (!limit.empty() && stod(limit) > 0) control.setTimeLimit(stod(limit));
+    } catch (invalid_argument &e) {
+        cout << "Invalid time limit, running without one" << endl;
+    }
+
+    control.setProgressCallback([](double bestDistance) {
+        cout << "\rBest distance so far: " << bestDistance << flush;
+    });
+    return control;
+}
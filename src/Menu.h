@@ -5,7 +5,9 @@
 #include <iostream>
 #include <stack>
 #include <limits>
+#include <memory>
 #include "Scraper.h"
+#include "TourIO.h"
 
 using namespace std;
 
@@ -17,7 +19,7 @@ private:
     stack<int> menuStack; /**< Stack to keep track of the visited menus. */
     int currentMenu; /**< Current menu. */
     Graph* gh; /**< Pointer to the graph. */
-    Graph loadedGraph; /**< Graph to be loaded. */
+    unique_ptr<Graph> loadedGraph; /**< Graph to be loaded. */
     Scraper::type_of_graph type; /**< Type of the graph. */
     string group; /**< Group of the graph. */
     string graph; /**< Name of the graph. */
@@ -75,6 +77,12 @@ private:
      */
     bool loadGraph(int group, string graph);
 
+    /**
+     * Function to ask the user for a time limit and set up a solve control that prints the progress of the solver.
+     * @return the solve control to be passed to the solver.
+     */
+    SolveControl getSolveControl();
+
     /**
      * Function to draw the choose algorithm menu.
      * Complexity: O(1)
@@ -0,0 +1,122 @@
+#include "MetricClosure.h"
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace {
+    /// Queue entry of Dijkstra's algorithm. Each search has its own nodes instead of writing to the vertexes.
+    struct DijkstraNode {
+        int queueIndex = 0; /**< Index of the node in the priority queue */
+        double dist = DBL_MAX; /**< Length of the shortest path found so far */
+        Vertex *vertex = nullptr; /**< Vertex the node stands for */
+
+        bool operator<(const DijkstraNode &other) const {
+            return dist < other.dist;
+        }
+    };
+}
+
+MetricClosure::MetricClosure(const vector<Vertex *> &vertexes, size_t maxRows)
+        : vertexes(vertexes), maxRows(maxRows), rows(maxRows == 0 ? numeric_limits<size_t>::max() : maxRows) {}
+
+double MetricClosure::distance(int from, int to) {
+    Scalar dist = (*row(from))[to];
+    return isinf(dist) ? DBL_MAX : dist;
+}
+
+bool MetricClosure::cachedDistance(int from, int to, double &dist) {
+    Row distances;
+    if (rows.get(from, distances)) dist = (*distances)[to];
+    else if (rows.get(to, distances)) dist = (*distances)[from];
+    else return false;
+    if (isinf(dist)) dist = DBL_MAX;
+    return true;
+}
+
+MetricClosure::Row MetricClosure::row(int source) {
+    Row distances;
+    if (!rows.get(source, distances)) {
+        distances = dijkstra(source);
+        rows.put(source, distances);
+    }
+    return distances;
+}
+
+void MetricClosure::computeAll(unsigned threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    if (rows.capacity() < vertexes.size()) return;
+
+    vector<int> pending;
+    Row cached;
+    for (int id = 0; id < vertexes.size(); id++) {
+        if (vertexes[id] != nullptr && !rows.get(id, cached)) pending.push_back(id);
+    }
+
+    atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < pending.size(); i = next++)
+            rows.put(pending[i], dijkstra(pending[i]));
+    };
+
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; t++) workers.emplace_back(worker);
+    worker();
+    for (thread &w: workers) w.join();
+}
+
+size_t MetricClosure::cachedRows() const {
+    return rows.statistics().size;
+}
+
+size_t MetricClosure::getMaxRows() const {
+    return maxRows;
+}
+
+void MetricClosure::updateEdge(int u, int v, double oldDist, double newDist) {
+    // A row keeps its distances if the edge, at its shorter length, is longer than the path it joins. The rows store
+    // rounded distances, so edges within the tolerance of a shortest path count as on it
+    const double tolerance = 1e-6;
+    double shorter = min(oldDist, newDist);
+    rows.eraseIf([&](const int &, const Row &row) {
+        double du = (*row)[u], dv = (*row)[v];
+        if (isinf(du) && isinf(dv)) return false;
+        return du + shorter <= dv * (1 + tolerance) || dv + shorter <= du * (1 + tolerance);
+    });
+}
+
+void MetricClosure::clear() {
+    rows.clear();
+}
+
+MetricClosure::Row MetricClosure::dijkstra(int source) const {
+    INSTRUMENT_COUNT(shortestPathSearches);
+    vector<DijkstraNode> nodes(vertexes.size());
+    MutablePriorityQueue<DijkstraNode> q;
+
+    nodes[source].vertex = vertexes[source];
+    nodes[source].dist = 0;
+    q.insert(&nodes[source]);
+
+    while (!q.empty()) {
+        DijkstraNode *u = q.extractMin();
+        for (Edge *e: u->vertex->getAdj()) {
+            DijkstraNode &w = nodes[e->getOther(u->vertex)->getId()];
+            double dist = u->dist + e->getDistance();
+            if (dist < w.dist) {
+                bool queued = w.dist != DBL_MAX;
+                w.vertex = e->getOther(u->vertex);
+                w.dist = dist;
+                if (queued) q.decreaseKey(&w);
+                else q.insert(&w);
+            }
+        }
+    }
+
+    // Paths are summed as double, only the result is rounded to the stored type
+    auto dist = make_shared<vector<Scalar>>(vertexes.size());
+    for (int id = 0; id < nodes.size(); id++)
+        (*dist)[id] = nodes[id].dist == DBL_MAX ? numeric_limits<Scalar>::infinity() : (Scalar) nodes[id].dist;
+    return dist;
+}
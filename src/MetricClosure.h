@@ -0,0 +1,112 @@
+#ifndef PROJECT_TSP_METRICCLOSURE_H
+#define PROJECT_TSP_METRICCLOSURE_H
+
+#include <memory>
+#include <vector>
+#include "VertexEdge.h"
+#include "ShardedLruCache.h"
+
+using namespace std;
+
+/**
+ * Shortest path distances between the vertexes of a (possibly incomplete) graph, i.e. the metric closure of the graph.
+ * The distances from a vertex are computed with Dijkstra's algorithm the first time they are needed and are kept in a
+ * least recently used cache of rows, which may be bounded to avoid keeping the whole V*V matrix. Rows can be requested
+ * from several threads at the same time.
+ */
+class MetricClosure {
+public:
+    typedef shared_ptr<const vector<Scalar>> Row;
+
+    /**
+     * Constructor for the MetricClosure class, no distances are computed yet
+     * @param vertexes - the vertexes of the graph, indexed by id (nullptr for unused ids)
+     * @param maxRows - maximum number of rows kept in memory, 0 to keep every row
+     */
+    explicit MetricClosure(const vector<Vertex *> &vertexes, size_t maxRows = 0);
+
+    /**
+     * Gets the length of the shortest path between two vertexes, computing the distances from the first one if needed
+     * Complexity: O(1) if the row of from is cached, O(E*log(V)) otherwise
+     * @param from - id of the first vertex
+     * @param to - id of the second vertex
+     * @return the length of the shortest path, DBL_MAX if the vertexes are not connected
+     */
+    double distance(int from, int to);
+
+    /**
+     * Gets the length of the shortest path between two vertexes if the row of either one is cached, without computing
+     * any row
+     * Complexity: O(1)
+     * @param from - id of the first vertex
+     * @param to - id of the second vertex
+     * @param dist - set to the length of the shortest path, DBL_MAX if the vertexes are not connected
+     * @return true if a cached row had the distance, false otherwise
+     */
+    bool cachedDistance(int from, int to, double &dist);
+
+    /**
+     * Gets the shortest path distances from a vertex to every other vertex, computing them if needed. Two threads
+     * missing the same row may both compute it
+     * Complexity: O(1) if the row is cached, O(E*log(V)) otherwise
+     * @param source - id of the source vertex
+     * @return the distances indexed by vertex id, infinity for the vertexes that are not connected to source. Valid
+     * even if the row is later evicted
+     */
+    Row row(int source);
+
+    /**
+     * Computes the rows of every vertex that is not cached yet, splitting the sources between several threads. Does
+     * nothing if the cache cannot hold every row
+     * Complexity: O(V*E*log(V)/T) where T is the number of threads
+     * @param threads - number of threads, 0 to use one per core
+     */
+    void computeAll(unsigned threads = 0);
+
+    /**
+     * Gets the number of rows that are currently cached
+     * Complexity: O(1)
+     * @return the number of cached rows
+     */
+    size_t cachedRows() const;
+
+    /**
+     * Gets the maximum number of rows kept in memory
+     * Complexity: O(1)
+     * @return the limit given to the constructor, 0 if every row is kept
+     */
+    size_t getMaxRows() const;
+
+    /**
+     * Removes the cached rows that may change when the length of an edge changes, i.e. those where a shortest path
+     * goes through the edge before the change (the edge is tight: the distance to one endpoint plus the old length
+     * equals the distance to the other) or can go through it after the change. Must be called after each change
+     * Complexity: O(R) where R is the number of cached rows
+     * @param u - id of one endpoint of the edge
+     * @param v - id of the other endpoint of the edge
+     * @param oldDist - length of the edge before the change
+     * @param newDist - length of the edge after the change
+     */
+    void updateEdge(int u, int v, double oldDist, double newDist);
+
+    /**
+     * Removes every cached row. Must be called when the vertexes or edges of the graph change
+     * Complexity: O(R) where R is the number of cached rows
+     */
+    void clear();
+
+private:
+    vector<Vertex *> vertexes; /**< Vertexes of the graph, indexed by id */
+    size_t maxRows; /**< Maximum number of rows kept in memory, 0 to keep every row */
+    ShardedLruCache<int, Row> rows; /**< Shortest path distances from the most recently used sources */
+
+    /**
+     * Runs Dijkstra's algorithm from a vertex. Uses its own queue nodes, so it can run in parallel with other sources
+     * Complexity: O(E*log(V))
+     * @param source - id of the source vertex
+     * @return the shortest path distances from source, indexed by vertex id
+     */
+    Row dijkstra(int source) const;
+};
+
+#endif //PROJECT_TSP_METRICCLOSURE_H
@@ -10,6 +10,7 @@
 #define DA_TP_CLASSES_MUTABLEPRIORITYQUEUE
 
 #include <vector>
+#include "Instrumentation.h"
 
 
 
@@ -49,6 +50,7 @@ bool MutablePriorityQueue<T>::empty() {
 
 template <class T>
 T* MutablePriorityQueue<T>::extractMin() {
+	INSTRUMENT_COUNT(heapExtractions);
 	auto x = H[1];
 	H[1] = H.back();
 	H.pop_back();
@@ -59,12 +61,14 @@ T* MutablePriorityQueue<T>::extractMin() {
 
 template <class T>
 void MutablePriorityQueue<T>::insert(T *x) {
+	INSTRUMENT_COUNT(heapInserts);
 	H.push_back(x);
 	heapifyUp(H.size()-1);
 }
 
 template <class T>
 void MutablePriorityQueue<T>::decreaseKey(T *x) {
+	INSTRUMENT_COUNT(heapDecreaseKeys);
 	heapifyUp(x->queueIndex);
 }
 
@@ -0,0 +1,54 @@
+#ifndef PROJECT_TSP_PARALLELSORT_H
+#define PROJECT_TSP_PARALLELSORT_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Sorts a range with several threads: each thread sorts one chunk, then neighbouring chunks are merged in parallel
+ * until a single sorted range is left. The result is the same as std::sort with the same comparator when the
+ * comparator defines a strict total order.
+ * Complexity: O(N*log(N)/T + N*log(T)) where N is the number of elements and T the number of threads
+ * @param first - iterator to the first element
+ * @param last - iterator past the last element
+ * @param comp - comparator
+ * @param threads - number of threads, 0 to use one per core
+ */
+template <class RandomIt, class Compare>
+void parallelSort(RandomIt first, RandomIt last, Compare comp, unsigned threads = 0) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    size_t size = last - first;
+    if (threads == 1 || size < 100000) {
+        sort(first, last, comp);
+        return;
+    }
+
+    vector<size_t> bounds;
+    for (unsigned t = 0; t <= threads; t++)
+        bounds.push_back(size * t / threads);
+
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([=]() { sort(first + bounds[t], first + bounds[t + 1], comp); });
+    }
+    for (thread &worker: workers) worker.join();
+
+    while (bounds.size() > 2) {
+        vector<size_t> merged;
+        workers.clear();
+        for (size_t c = 0; c + 2 < bounds.size(); c += 2) {
+            size_t lo = bounds[c], mid = bounds[c + 1], hi = bounds[c + 2];
+            workers.emplace_back([=]() { inplace_merge(first + lo, first + mid, first + hi, comp); });
+            merged.push_back(lo);
+        }
+        if (bounds.size() % 2 == 0) merged.push_back(bounds[bounds.size() - 2]);
+        merged.push_back(bounds.back());
+        for (thread &worker: workers) worker.join();
+        bounds = merged;
+    }
+}
+
+#endif //PROJECT_TSP_PARALLELSORT_H
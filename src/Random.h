@@ -0,0 +1,59 @@
+#ifndef PROJECT_TSP_RANDOM_H
+#define PROJECT_TSP_RANDOM_H
+
+#include <cstdint>
+#include <random>
+#include <utility>
+
+using namespace std;
+
+/*
+ * Random draws of the randomized solvers. mt19937 and seed_seq give the same numbers with every standard library, but
+ * the algorithms of uniform_int_distribution, uniform_real_distribution and shuffle are left to the implementation, so
+ * the solvers draw through these functions to find the same tours from the same seed on every platform.
+ */
+
+/**
+ * Draws an integer uniformly from a range, rejecting the draws that would favour the lowest values
+ * Complexity: O(1) expected
+ * @param rng - random number generator
+ * @param lo - smallest value
+ * @param hi - largest value, at least lo
+ * @return the value drawn
+ */
+inline int uniformInt(mt19937 &rng, int lo, int hi) {
+    uint64_t range = (uint64_t) ((int64_t) hi - lo) + 1;
+    uint64_t limit = (1ull << 32) - (1ull << 32) % range;
+    uint64_t draw;
+    do {
+        draw = rng();
+    } while (draw >= limit);
+    return (int) (lo + (int64_t) (draw % range));
+}
+
+/**
+ * Draws a real number uniformly from [0, 1), with the 53 bits of precision of a double
+ * Complexity: O(1)
+ * @param rng - random number generator
+ * @return the value drawn
+ */
+inline double uniformReal(mt19937 &rng) {
+    uint64_t high = rng() >> 5;
+    uint64_t low = rng() >> 6;
+    return (double) (high << 26 | low) / (double) (1ull << 53);
+}
+
+/**
+ * Shuffles a range (Fisher-Yates), every permutation being equally likely
+ * Complexity: O(N) where N is the number of elements
+ * @param first - iterator to the first element
+ * @param last - iterator past the last element
+ * @param rng - random number generator
+ */
+template <class RandomIt>
+void uniformShuffle(RandomIt first, RandomIt last, mt19937 &rng) {
+    for (int i = (int) (last - first) - 1; i > 0; i--)
+        swap(first[i], first[uniformInt(rng, 0, i)]);
+}
+
+#endif //PROJECT_TSP_RANDOM_H
@@ -10,6 +10,7 @@
 using namespace std;
 
 void Scraper::scrape_graph(string file_name, Graph &gh, enum type_of_graph type) {
+    INSTRUMENT_SCOPE("scrape_graph");
     ifstream file(file_name);
     string line;
     if (type != medium) getline(file,line);
@@ -32,11 +33,18 @@ void Scraper::scrape_graph(string file_name, Graph &gh, enum type_of_graph type)
             getline(iss,dist,',');
             if (dist.back() == '\r') dist.substr(0,dist.size()-1);
 
-            auto v1 = gh.findVertex(stoi(id1)) == nullptr ? new Vertex(stoi(id1)) : gh.findVertex(stoi(id1));
-            auto v2 = gh.findVertex(stoi(id2)) == nullptr ? new Vertex(stoi(id2)) : gh.findVertex(stoi(id2));
+            // Vertexes are looked up by their id in the file, the graph gives them dense ids when they are added
+            auto v1 = gh.findVertexByOriginalId(stoi(id1));
+            if (v1 == nullptr) {
+                v1 = new Vertex(stoi(id1));
+                gh.addVertex(v1);
+            }
+            auto v2 = gh.findVertexByOriginalId(stoi(id2));
+            if (v2 == nullptr) {
+                v2 = new Vertex(stoi(id2));
+                gh.addVertex(v2);
+            }
 
-            gh.addVertex(v1);
-            gh.addVertex(v2);
             gh.addBidirectionalEdge(v1,v2,stod(dist));
         }
     }
@@ -44,6 +52,7 @@ void Scraper::scrape_graph(string file_name, Graph &gh, enum type_of_graph type)
         string edges_file_name = file_name.substr(0,file_name.find_last_of('/') + 1) + "edges.csv";
         scrape_graph_edges(edges_file_name, gh);
     }
+    gh.buildEdgeIndexes();
 }
 
 void Scraper::scrape_graph_edges(std::string file_name, Graph &gh) {
@@ -58,11 +67,9 @@ void Scraper::scrape_graph_edges(std::string file_name, Graph &gh) {
         getline(iss,id2,',');
         getline(iss,dist,'\r');
 
-        auto v1 = gh.findVertex(stoi(id1));
-        auto v2 = gh.findVertex(stoi(id2));
+        auto v1 = gh.findVertexByOriginalId(stoi(id1));
+        auto v2 = gh.findVertexByOriginalId(stoi(id2));
 
-        gh.addVertex(v1);
-        gh.addVertex(v2);
         gh.addBidirectionalEdge(v1,v2,stod(dist));
     }
 }
\ No newline at end of file
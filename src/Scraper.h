@@ -17,7 +17,7 @@ public:
     };
 
     /**
-     * Scrapes a graph from a file.
+     * Scrapes a graph from a file and builds the edge indexes of its vertexes.
      * Complexity: O(L*V) in toy and medium graphs where L is the number of lines of the file and V is the number of vertexes,
      * and O(L+E) in real graphs, where L is the number of lines of the nodes file and E is the number of lines of the edges file.
      * @param file_name - the name of the file to be scraped;
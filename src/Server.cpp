@@ -0,0 +1,250 @@
+#include "Server.h"
+#include <fstream>
+#include <iomanip>
+
+Server::Server(unsigned threads) : threads(threads) {}
+
+vector<string> Server::algorithms() {
+    return {"backtracking", "triangularApproximation", "nearestNeighbour", "christofides", "hilbertCurve",
+            "greedyEdge", "savings", "cheapestInsertion", "farthestInsertion", "randomInsertion", "partitionMerge",
+            "twoOpt", "parallelTwoOpt", "iteratedLocalSearch", "simulatedAnnealing", "geneticAlgorithm"};
+}
+
+void Server::run(istream &in, ostream &out) {
+    this->out = &out;
+    // Declared here so that leaving the loop waits for the queued solves before returning
+    ThreadPool pool(threads);
+
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        istringstream args(line);
+        string request;
+        if (!(args >> request)) continue;
+
+        if (request == "quit") break;
+        else if (request == "load") load(args);
+        else if (request == "unload") unload(args);
+        else if (request == "list") list();
+        else if (request == "solve") solve(args, pool);
+        else if (request == "subset") subset(args, pool);
+        else reply("error unknown request " + request);
+    }
+}
+
+void Server::reply(const string &line) {
+    lock_guard<mutex> lock(outLock);
+    *out << line << endl;
+}
+
+void Server::load(istringstream &args) {
+    string name, typeName, file, option;
+    if (!(args >> name >> typeName >> file)) {
+        reply("error usage: load NAME toy|medium|real FILE [closure]");
+        return;
+    }
+    args >> option;
+
+    Scraper::type_of_graph type;
+    if (typeName == "toy") type = Scraper::toy;
+    else if (typeName == "medium") type = Scraper::medium;
+    else if (typeName == "real") type = Scraper::real;
+    else {
+        reply("error unknown graph type " + typeName);
+        return;
+    }
+    {
+        lock_guard<mutex> lock(graphsLock);
+        if (graphs.count(name)) {
+            reply("error graph " + name + " is already loaded");
+            return;
+        }
+    }
+    if (!ifstream(file).good()) {
+        reply("error cannot read " + file);
+        return;
+    }
+
+    auto loaded = make_shared<LoadedGraph>();
+    try {
+        Scraper::scrape_graph(file, loaded->graph, type);
+    } catch (exception &e) {
+        reply("error cannot parse " + file);
+        return;
+    }
+    if (loaded->graph.getVertexSet().empty()) {
+        reply("error " + file + " has no vertexes");
+        return;
+    }
+    if (type == Scraper::real) loaded->graph.spatialRenumber();
+    if (option == "closure") {
+        loaded->graph.setMetricClosure(true);
+        loaded->graph.computeMetricClosure();
+    }
+
+    size_t size = loaded->graph.getVertexSet().size();
+    {
+        lock_guard<mutex> lock(graphsLock);
+        if (!graphs.emplace(name, loaded).second) {
+            reply("error graph " + name + " is already loaded");
+            return;
+        }
+    }
+    reply("ok loaded " + name + " " + to_string(size));
+}
+
+void Server::unload(istringstream &args) {
+    string name;
+    args >> name;
+    lock_guard<mutex> lock(graphsLock);
+    if (graphs.erase(name) == 0) reply("error unknown graph " + name);
+    else reply("ok unloaded " + name);
+}
+
+void Server::list() {
+    string line = "ok";
+    lock_guard<mutex> lock(graphsLock);
+    for (auto &entry: graphs)
+        line += " " + entry.first + ":" + to_string(entry.second->graph.getVertexSet().size());
+    reply(line);
+}
+
+void Server::solve(istringstream &args, ThreadPool &pool) {
+    string id, name, algorithm;
+    if (!(args >> id >> name >> algorithm)) {
+        reply("error usage: solve ID NAME ALGORITHM [SECONDS [SEED]]");
+        return;
+    }
+    double seconds = 0;
+    if (!(args >> seconds) && !args.eof()) {
+        reply("error " + id + " invalid time limit");
+        return;
+    }
+    unsigned seed = 0;
+    if (!(args >> seed) && !args.eof()) {
+        reply("error " + id + " invalid seed");
+        return;
+    }
+    vector<string> known = algorithms();
+    if (find(known.begin(), known.end(), algorithm) == known.end()) {
+        reply("error " + id + " unknown algorithm " + algorithm);
+        return;
+    }
+
+    shared_ptr<LoadedGraph> loaded;
+    {
+        lock_guard<mutex> lock(graphsLock);
+        auto it = graphs.find(name);
+        if (it != graphs.end()) loaded = it->second;
+    }
+    if (loaded == nullptr) {
+        reply("error " + id + " unknown graph " + name);
+        return;
+    }
+
+    // The job keeps the graph alive even if it is unloaded before the solve runs
+    pool.submit([this, loaded, id, algorithm, seconds, seed]() {
+        lock_guard<mutex> lock(loaded->lock);
+        Graph &graph = loaded->graph;
+        if (algorithm == "christofides" && !graph.isComplete()) {
+            reply("error " + id + " christofides needs a complete graph");
+            return;
+        }
+
+        // The time limit starts when the solve starts running, not when it was queued
+        SolveControl control;
+        if (seconds > 0) control.setTimeLimit(seconds);
+        vInt path(graph.getVertexSet().size());
+        double distance = runAlgorithm(graph, algorithm, path, control, seed);
+
+        ostringstream line;
+        line << "result " << id << " " << fixed << setprecision(3) << distance;
+        for (int v: path)
+            line << " " << graph.getOriginalId(v);
+        reply(line.str());
+    });
+}
+
+void Server::subset(istringstream &args, ThreadPool &pool) {
+    string id, name;
+    double seconds;
+    if (!(args >> id >> name >> seconds)) {
+        reply("error usage: subset ID NAME SECONDS V1 V2 ...");
+        return;
+    }
+
+    shared_ptr<LoadedGraph> loaded;
+    {
+        lock_guard<mutex> lock(graphsLock);
+        auto it = graphs.find(name);
+        if (it != graphs.end()) loaded = it->second;
+    }
+    if (loaded == nullptr) {
+        reply("error " + id + " unknown graph " + name);
+        return;
+    }
+
+    vInt originalIds;
+    int originalId;
+    while (args >> originalId)
+        originalIds.push_back(originalId);
+    if (!args.eof() || originalIds.empty()) {
+        reply("error " + id + " invalid vertex list");
+        return;
+    }
+
+    // Subset tours only read the distances of the graph, so they do not take its lock
+    pool.submit([this, loaded, id, seconds, originalIds]() {
+        Graph &graph = loaded->graph;
+
+        vInt ids;
+        for (int originalId: originalIds) {
+            Vertex *v = graph.findVertexByOriginalId(originalId);
+            if (v == nullptr) {
+                reply("error " + id + " unknown vertex " + to_string(originalId));
+                return;
+            }
+            ids.push_back(v->getId());
+        }
+
+        SolveControl control;
+        if (seconds > 0) control.setTimeLimit(seconds);
+        vInt path;
+        double distance;
+        try {
+            distance = graph.subsetTsp(ids, path, control, 1);
+        } catch (invalid_argument &e) {
+            reply("error " + id + " " + e.what());
+            return;
+        }
+
+        ostringstream line;
+        line << "result " << id << " " << fixed << setprecision(3) << distance;
+        for (int v: path)
+            line << " " << graph.getOriginalId(v);
+        reply(line.str());
+    });
+}
+
+double Server::runAlgorithm(Graph &graph, const string &algorithm, vInt &path, const SolveControl &control,
+                            unsigned seed) {
+    if (algorithm == "backtracking") return graph.tspBT(path, control);
+    if (algorithm == "triangularApproximation") return graph.calculateTahTotalDistance(path);
+    if (algorithm == "nearestNeighbour") return graph.nearestNeighbourRouteTsp(path);
+    if (algorithm == "christofides") return graph.christofides(path);
+    if (algorithm == "hilbertCurve") return graph.hilbertCurveTsp(path);
+    if (algorithm == "savings") return graph.savingsTsp(path);
+    if (algorithm == "cheapestInsertion") return graph.insertionTsp(path, Graph::cheapest_insertion);
+    if (algorithm == "farthestInsertion") return graph.insertionTsp(path, Graph::farthest_insertion);
+    if (algorithm == "randomInsertion") return graph.insertionTsp(path, Graph::random_insertion, seed);
+    // Each solve uses a single thread, the pool decides how many run at the same time
+    if (algorithm == "partitionMerge") return graph.partitionTsp(path, control, 1);
+
+    double distance = graph.greedyEdgeTsp(path);
+    if (algorithm == "twoOpt") return graph.twoOpt(path, distance, control);
+    if (algorithm == "parallelTwoOpt") return graph.parallelTwoOpt(path, distance, control, 1);
+    if (algorithm == "iteratedLocalSearch") return graph.iteratedLocalSearch(path, distance, control, 1, seed);
+    if (algorithm == "simulatedAnnealing") return graph.simulatedAnnealing(path, distance, control, 1, seed);
+    if (algorithm == "geneticAlgorithm") return graph.geneticAlgorithm(path, distance, control, 1, seed);
+    return distance;
+}
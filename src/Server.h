@@ -0,0 +1,119 @@
+#ifndef PROJECT_TSP_SERVER_H
+#define PROJECT_TSP_SERVER_H
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include "Scraper.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/**
+ * Long-running solver process that keeps graphs loaded in memory by name and answers requests read one per line.
+ * Solves run on a bounded thread pool, so they do not pay for loading the graph, and their results are written as
+ * soon as they finish, tagged with the id of the request. A graph is solved by one solve request at a time (the
+ * algorithms keep their state in the vertexes), different graphs are solved in parallel. Subset requests only read the
+ * distances, so any number of them can run on the same graph at the same time.
+ *
+ * Requests:
+ *   load NAME toy|medium|real FILE [closure]   loads a graph, with shortest path distances for missing edges if closure
+ *   unload NAME                                removes a graph once the solves that use it finish
+ *   list                                       lists the loaded graphs
+ *   solve ID NAME ALGORITHM [SECONDS [SEED]]   solves a graph in the background, within SECONDS if given (0 for no
+ *                                              limit), randomized algorithms use SEED (0 by default)
+ *   subset ID NAME SECONDS V1 V2 ...           solves the tour of some vertexes of a graph, SECONDS = 0 for no limit
+ *   quit                                       waits for the queued solves and exits
+ * Replies:
+ *   ok ...                                     the request was done
+ *   result ID DISTANCE V0 V1 ... V0            tour of a solve or subset request, with the ids of the input file
+ *   error [ID] MESSAGE                         the request failed
+ */
+class Server {
+public:
+    /**
+     * Constructor for the Server class
+     * @param threads - number of solves that can run at the same time, 0 to use one per core
+     */
+    explicit Server(unsigned threads = 0);
+
+    /**
+     * Reads requests until the end of the input or a quit request, then waits for the solves in progress
+     * @param in - the stream the requests are read from
+     * @param out - the stream the replies are written to
+     */
+    void run(istream &in, ostream &out);
+
+    /**
+     * Gets the names of the algorithms accepted by solve requests
+     * @return the algorithm names, the improvement algorithms start from the greedy edge tour
+     */
+    static vector<string> algorithms();
+
+private:
+    /// A graph kept in memory, with the lock held by the solve that is using it.
+    struct LoadedGraph {
+        Graph graph; /**< The graph */
+        mutex lock; /**< Held while an algorithm runs on the graph */
+    };
+
+    map<string, shared_ptr<LoadedGraph>> graphs; /**< Loaded graphs by name */
+    mutex graphsLock; /**< Guards graphs */
+    ostream *out = nullptr; /**< Stream the replies are written to */
+    mutex outLock; /**< Guards out, so replies from different threads are not mixed */
+    unsigned threads; /**< Number of workers of the thread pool */
+
+    /**
+     * Writes one reply line
+     * @param line - the reply, without the line break
+     */
+    void reply(const string &line);
+
+    /**
+     * Handles a load request
+     * @param args - the arguments of the request
+     */
+    void load(istringstream &args);
+
+    /**
+     * Handles an unload request
+     * @param args - the arguments of the request
+     */
+    void unload(istringstream &args);
+
+    /**
+     * Handles a list request
+     */
+    void list();
+
+    /**
+     * Handles a solve request, queueing the solve on the pool
+     * @param args - the arguments of the request
+     * @param pool - the pool the solve is run on
+     */
+    void solve(istringstream &args, ThreadPool &pool);
+
+    /**
+     * Handles a subset request, queueing the solve on the pool
+     * @param args - the arguments of the request
+     * @param pool - the pool the solve is run on
+     */
+    void subset(istringstream &args, ThreadPool &pool);
+
+    /**
+     * Runs an algorithm on a graph. Must be called with the lock of the graph held
+     * @param graph - the graph
+     * @param algorithm - name of the algorithm, one of algorithms()
+     * @param path - filled with the tour, starting and ending at vertex 0
+     * @param control - deadline of the solve
+     * @param seed - seed of the randomized algorithms
+     * @return the distance of the tour
+     */
+    static double runAlgorithm(Graph &graph, const string &algorithm, vInt &path, const SolveControl &control,
+                               unsigned seed);
+};
+
+#endif //PROJECT_TSP_SERVER_H
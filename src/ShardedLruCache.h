@@ -0,0 +1,192 @@
+#ifndef PROJECT_TSP_SHARDEDLRUCACHE_H
+#define PROJECT_TSP_SHARDEDLRUCACHE_H
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Bounded key-value cache that evicts the least recently used entry when full. The keys are split between shards,
+ * each with its own lock and its own share of the capacity, so several threads can use the cache at the same time
+ * without all waiting on a single lock.
+ */
+template <class Key, class Value, class Hash = hash<Key>>
+class ShardedLruCache {
+public:
+
+    /// Lookup counters and size of the cache, summed over every shard.
+    struct Statistics {
+        unsigned long long hits = 0; /**< Number of lookups that found their key */
+        unsigned long long misses = 0; /**< Number of lookups that did not find their key */
+        unsigned long long evictions = 0; /**< Number of entries dropped to make room for new ones */
+        size_t size = 0; /**< Number of entries in the cache */
+
+        /**
+         * Gets the fraction of lookups that found their key
+         * @return the hit rate between 0 and 1, or 0 if there were no lookups
+         */
+        double hitRate() const {
+            return hits + misses == 0 ? 0 : (double) hits / (double) (hits + misses);
+        }
+    };
+
+    /**
+     * Constructor for the ShardedLruCache class
+     * @param capacity - maximum number of entries, split evenly between the shards
+     * @param shardCount - number of shards, each one with its own lock
+     */
+    explicit ShardedLruCache(size_t capacity, unsigned shardCount = 16) : totalCapacity(capacity) {
+        shardCount = max(1u, shardCount);
+        for (unsigned s = 0; s < shardCount; s++)
+            shards.emplace_back(new Shard(capacity / shardCount + (capacity % shardCount != 0)));
+    }
+
+    /**
+     * Looks up a key and marks it as the most recently used entry of its shard
+     * Complexity: O(1) on average
+     * @param key - the key to look up
+     * @param value - set to the cached value if the key is found
+     * @return true if the key was found, false otherwise
+     */
+    bool get(const Key &key, Value &value) {
+        Shard &shard = shardOf(key);
+        lock_guard<mutex> lock(shard.lock);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            shard.stats.misses++;
+            return false;
+        }
+        shard.stats.hits++;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        value = it->second->second;
+        return true;
+    }
+
+    /**
+     * Stores a value, replacing the previous value of the key, and evicts the least recently used entry of the shard
+     * if it is over its capacity
+     * Complexity: O(1) on average
+     * @param key - the key
+     * @param value - the value to be stored
+     */
+    void put(const Key &key, const Value &value) {
+        Shard &shard = shardOf(key);
+        lock_guard<mutex> lock(shard.lock);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            it->second->second = value;
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+        shard.entries.emplace_front(key, value);
+        shard.index[key] = shard.entries.begin();
+        if (shard.entries.size() > shard.capacity) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+            shard.stats.evictions++;
+        }
+    }
+
+    /**
+     * Removes every entry, keeping the statistics
+     * Complexity: O(N) where N is the number of entries
+     */
+    void clear() {
+        for (auto &shard: shards) {
+            lock_guard<mutex> lock(shard->lock);
+            shard->entries.clear();
+            shard->index.clear();
+        }
+    }
+
+    /**
+     * Removes the entries for which a predicate is true, keeping the statistics
+     * Complexity: O(N) calls to the predicate where N is the number of entries
+     * @param predicate - function of a key and its value, true if the entry must be removed
+     */
+    void eraseIf(const function<bool(const Key &, const Value &)> &predicate) {
+        for (auto &shard: shards) {
+            lock_guard<mutex> lock(shard->lock);
+            for (auto it = shard->entries.begin(); it != shard->entries.end();) {
+                if (predicate(it->first, it->second)) {
+                    shard->index.erase(it->first);
+                    it = shard->entries.erase(it);
+                } else {
+                    it++;
+                }
+            }
+        }
+    }
+
+    /**
+     * Sets the hit, miss and eviction counters back to zero
+     * Complexity: O(S) where S is the number of shards
+     */
+    void resetStatistics() {
+        for (auto &shard: shards) {
+            lock_guard<mutex> lock(shard->lock);
+            shard->stats = Statistics();
+        }
+    }
+
+    /**
+     * Gets the counters and size of the cache
+     * Complexity: O(S) where S is the number of shards
+     * @return the statistics summed over every shard
+     */
+    Statistics statistics() const {
+        Statistics total;
+        for (auto &shard: shards) {
+            lock_guard<mutex> lock(shard->lock);
+            total.hits += shard->stats.hits;
+            total.misses += shard->stats.misses;
+            total.evictions += shard->stats.evictions;
+            total.size += shard->entries.size();
+        }
+        return total;
+    }
+
+    /**
+     * Gets the maximum number of entries of the cache. Each shard holds an equal part of it, so a shard may start
+     * evicting before the whole cache is full
+     * @return the capacity the cache was created with
+     */
+    size_t capacity() const {
+        return totalCapacity;
+    }
+
+private:
+
+    /// Part of the cache guarded by one lock. The entries are kept from the most to the least recently used.
+    struct Shard {
+        explicit Shard(size_t capacity) : capacity(max<size_t>(1, capacity)) {}
+
+        mutable mutex lock; /**< Guards every other member of the shard */
+        list<pair<Key, Value>> entries; /**< Entries, most recently used first */
+        unordered_map<Key, typename list<pair<Key, Value>>::iterator, Hash> index; /**< Position of each key */
+        size_t capacity; /**< Maximum number of entries of the shard */
+        Statistics stats; /**< Counters of the shard, the size field is not used */
+    };
+
+    vector<unique_ptr<Shard>> shards; /**< Shards of the cache */
+    size_t totalCapacity; /**< Maximum number of entries of the whole cache */
+
+    /**
+     * Finds the shard a key belongs to. The hash is mixed first, so the choice of shard does not follow the choice of
+     * bucket inside the shard's hash table
+     * @param key - the key
+     * @return the shard of the key
+     */
+    Shard &shardOf(const Key &key) const {
+        unsigned long long h = Hash()(key) * 0x9E3779B97F4A7C15ull;
+        return *shards[(h >> 32) % shards.size()];
+    }
+};
+
+#endif //PROJECT_TSP_SHARDEDLRUCACHE_H
@@ -0,0 +1,62 @@
+#include "SolveControl.h"
+#include <algorithm>
+
+SolveControl::SolveControl() : stopped(false) {}
+
+SolveControl::SolveControl(const SolveControl &other)
+        : hasDeadline(other.hasDeadline), deadline(other.deadline), cancelled(other.cancelled),
+          progress(other.progress), stopped(other.stopped.load()) {}
+
+SolveControl &SolveControl::operator=(const SolveControl &other) {
+    hasDeadline = other.hasDeadline;
+    deadline = other.deadline;
+    cancelled = other.cancelled;
+    progress = other.progress;
+    stopped = other.stopped.load();
+    return *this;
+}
+
+void SolveControl::setTimeLimit(double seconds) {
+    setDeadline(chrono::steady_clock::now() +
+                chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds)));
+}
+
+void SolveControl::setDeadline(chrono::steady_clock::time_point deadline) {
+    this->hasDeadline = true;
+    this->deadline = deadline;
+}
+
+void SolveControl::setCancellationToken(const atomic<bool> *token) {
+    this->cancelled = token;
+}
+
+void SolveControl::setProgressCallback(ProgressCallback callback) {
+    this->progress = std::move(callback);
+}
+
+bool SolveControl::shouldStop() const {
+    if (stopped.load(memory_order_relaxed)) return true;
+    if ((cancelled != nullptr && cancelled->load(memory_order_relaxed)) ||
+        (hasDeadline && chrono::steady_clock::now() >= deadline)) {
+        stopped.store(true, memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool SolveControl::wasStopped() const {
+    return stopped.load(memory_order_relaxed);
+}
+
+void SolveControl::stop() const {
+    stopped.store(true, memory_order_relaxed);
+}
+
+double SolveControl::remainingSeconds() const {
+    if (!hasDeadline) return -1;
+    return max(0.0, chrono::duration<double>(deadline - chrono::steady_clock::now()).count());
+}
+
+void SolveControl::reportProgress(double bestDistance) const {
+    if (progress) progress(bestDistance);
+}
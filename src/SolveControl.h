@@ -0,0 +1,103 @@
+#ifndef PROJECT_TSP_SOLVECONTROL_H
+#define PROJECT_TSP_SOLVECONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+using namespace std;
+
+/**
+ * Limits and callbacks passed to the long-running solvers. A solver checks shouldStop() periodically and, once it
+ * returns true, stops searching and returns the best tour found so far. Every time the solver finds a better tour it
+ * calls reportProgress() with its distance.
+ */
+class SolveControl {
+public:
+    typedef function<void(double)> ProgressCallback;
+
+    /**
+     * Constructor for a SolveControl without deadline, cancellation token or progress callback
+     */
+    SolveControl();
+
+    /**
+     * Copy constructor, the copy keeps the limits, callback and stopped state of the original
+     * @param other - the control to be copied
+     */
+    SolveControl(const SolveControl &other);
+
+    /**
+     * Copy assignment, keeps the limits, callback and stopped state of the original
+     * @param other - the control to be copied
+     * @return this control
+     */
+    SolveControl &operator=(const SolveControl &other);
+
+    /**
+     * Sets a deadline relative to the current time
+     * @param seconds - time the solver is allowed to run for
+     */
+    void setTimeLimit(double seconds);
+
+    /**
+     * Sets an absolute deadline
+     * @param deadline - point in time after which the solver must stop
+     */
+    void setDeadline(chrono::steady_clock::time_point deadline);
+
+    /**
+     * Sets a cancellation token. The solver stops as soon as it notices the token is true
+     * @param token - the token, must outlive the solve
+     */
+    void setCancellationToken(const atomic<bool> *token);
+
+    /**
+     * Sets the function called with the current best distance whenever the solver improves its tour
+     * @param callback - the progress callback
+     */
+    void setProgressCallback(ProgressCallback callback);
+
+    /**
+     * Checks if the solver should stop, either because the deadline has passed or the token was cancelled.
+     * Once it returns true it keeps returning true
+     * Complexity: O(1)
+     * @return true if the solver must stop, false otherwise
+     */
+    bool shouldStop() const;
+
+    /**
+     * Checks if a previous call to shouldStop() returned true, without reading the clock
+     * Complexity: O(1)
+     * @return true if the solve was interrupted, false otherwise
+     */
+    bool wasStopped() const;
+
+    /**
+     * Marks the solve as interrupted, so that shouldStop() and wasStopped() return true from now on. Used to pass on
+     * the stop of a solver that ran with a copy of this control
+     * Complexity: O(1)
+     */
+    void stop() const;
+
+    /**
+     * Gets the time left until the deadline
+     * @return the remaining time in seconds, or a negative value if there is no deadline
+     */
+    double remainingSeconds() const;
+
+    /**
+     * Calls the progress callback, if there is one
+     * @param bestDistance - distance of the best tour found so far
+     */
+    void reportProgress(double bestDistance) const;
+
+private:
+    bool hasDeadline = false; /**< Whether a deadline was set */
+    chrono::steady_clock::time_point deadline; /**< Point in time after which the solver must stop */
+    const atomic<bool> *cancelled = nullptr; /**< Cancellation token, nullptr if there is none */
+    ProgressCallback progress; /**< Function called when the solver finds a better tour */
+    mutable atomic<bool> stopped; /**< Whether shouldStop() has already returned true */
+};
+
+#endif //PROJECT_TSP_SOLVECONTROL_H
@@ -0,0 +1,91 @@
+#ifndef PROJECT_TSP_THREADPOOL_H
+#define PROJECT_TSP_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Fixed number of worker threads that run the submitted jobs in the order they were submitted. The destructor waits for
+ * every job that was already submitted.
+ */
+class ThreadPool {
+public:
+    /**
+     * Constructor for the ThreadPool class, starts the workers
+     * @param threads - number of worker threads, 0 to use one per core
+     */
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        for (unsigned t = 0; t < threads; t++)
+            workers.emplace_back([this]() { work(); });
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Destructor, runs the jobs left in the queue and joins the workers
+     */
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(jobsLock);
+            stopping = true;
+        }
+        jobsReady.notify_all();
+        for (thread &worker: workers) worker.join();
+    }
+
+    /**
+     * Queues a job, which is run by the first idle worker
+     * Complexity: O(1)
+     * @param job - the job to be run
+     */
+    void submit(function<void()> job) {
+        {
+            lock_guard<mutex> lock(jobsLock);
+            jobs.push_back(std::move(job));
+        }
+        jobsReady.notify_one();
+    }
+
+    /**
+     * Gets the number of worker threads
+     * @return the number of workers
+     */
+    size_t size() const {
+        return workers.size();
+    }
+
+private:
+    vector<thread> workers; /**< Worker threads */
+    deque<function<void()>> jobs; /**< Jobs waiting for a worker */
+    mutex jobsLock; /**< Guards jobs and stopping */
+    condition_variable jobsReady; /**< Notified when a job is queued or the pool is stopping */
+    bool stopping = false; /**< Set by the destructor, workers exit once the queue is empty */
+
+    /**
+     * Runs queued jobs until the pool is stopping and the queue is empty
+     */
+    void work() {
+        while (true) {
+            function<void()> job;
+            {
+                unique_lock<mutex> lock(jobsLock);
+                jobsReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+#endif //PROJECT_TSP_THREADPOOL_H
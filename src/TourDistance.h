@@ -0,0 +1,183 @@
+#ifndef PROJECT_TSP_TOURDISTANCE_H
+#define PROJECT_TSP_TOURDISTANCE_H
+
+#include <cmath>
+#include <vector>
+#include "Graph.h"
+
+using namespace std;
+
+/**
+ * Distance functor used by the local search and metaheuristics. Cities are identified by their index in the cities
+ * vector (0..n-1) and the distance between them is the one computed by Graph::calculateTwoVerticesDist.
+ */
+class GraphDistance {
+public:
+    /**
+     * Constructor for the GraphDistance class
+     * @param graph - the graph the cities belong to
+     * @param cities - the cities of the tour, must outlive the functor
+     */
+    GraphDistance(Graph &graph, const vector<Vertex *> &cities) : graph(graph), cities(cities) {}
+
+    /**
+     * Computes the distance between two cities
+     * Complexity: the same as Graph::calculateTwoVerticesDist
+     * @param a - index of the first city
+     * @param b - index of the second city
+     * @return the distance between the two cities
+     */
+    double operator()(int a, int b) const {
+        return graph.calculateTwoVerticesDist(cities[a], cities[b]);
+    }
+
+    /**
+     * Gets the number of cities
+     * @return the number of cities
+     */
+    int size() const {
+        return (int) cities.size();
+    }
+
+private:
+    Graph &graph; /**< Graph the cities belong to */
+    const vector<Vertex *> &cities; /**< Vertex of each city index */
+};
+
+/**
+ * Distance functor over a precomputed matrix, used when the same small set of cities is queried many times. Cities are
+ * identified by their row (0..n-1) and the matrix is stored row by row.
+ */
+class MatrixDistance {
+public:
+    /**
+     * Constructor for the MatrixDistance class
+     * @param matrix - the n*n distances, row by row, must outlive the functor
+     * @param n - the number of cities
+     */
+    MatrixDistance(const vector<double> &matrix, int n) : matrix(matrix), n(n) {}
+
+    /**
+     * Gets the distance between two cities
+     * Complexity: O(1)
+     * @param a - index of the first city
+     * @param b - index of the second city
+     * @return the distance between the two cities
+     */
+    double operator()(int a, int b) const {
+        return matrix[(size_t) a * n + b];
+    }
+
+    /**
+     * Gets the number of cities
+     * @return the number of cities
+     */
+    int size() const {
+        return n;
+    }
+
+private:
+    const vector<double> &matrix; /**< Distances between the cities, row by row */
+    int n; /**< Number of cities */
+};
+
+/**
+ * Distance functor for complete graphs. The lengths of the edges between the cities are copied once into a matrix, so
+ * a distance is a single load, without looking for the edge or falling back to another distance.
+ */
+class CompleteDistance {
+public:
+    /**
+     * Constructor for the CompleteDistance class
+     * Complexity: O(n*E) where n is the number of cities and E the number of edges of a vertex
+     * @param cities - the cities, every two of them must be joined by an edge
+     */
+    explicit CompleteDistance(const vector<Vertex *> &cities) : n((int) cities.size()) {
+        int maxId = 0;
+        for (Vertex *v: cities) maxId = max(maxId, v->getId());
+        vInt index(maxId + 1, -1);
+        for (int i = 0; i < n; i++) index[cities[i]->getId()] = i;
+
+        matrix.assign((size_t) n * n, 0);
+        for (int i = 0; i < n; i++) {
+            // Edges are read in reverse so that, like findEdge, the first edge towards a city wins
+            const vector<Edge *> &adj = cities[i]->getAdj();
+            for (auto it = adj.rbegin(); it != adj.rend(); it++) {
+                int id = (*it)->getOther(cities[i])->getId();
+                if (id <= maxId && index[id] != -1) matrix[(size_t) i * n + index[id]] = (Scalar) (*it)->getDistance();
+            }
+        }
+    }
+
+    /**
+     * Gets the distance between two cities
+     * Complexity: O(1)
+     * @param a - index of the first city
+     * @param b - index of the second city
+     * @return the length of the edge between the two cities
+     */
+    double operator()(int a, int b) const {
+        return matrix[(size_t) a * n + b];
+    }
+
+    /**
+     * Gets the number of cities
+     * @return the number of cities
+     */
+    int size() const {
+        return n;
+    }
+
+private:
+    vector<Scalar> matrix; /**< Lengths of the edges between the cities, row by row */
+    int n; /**< Number of cities */
+};
+
+/**
+ * Distance functor over the shortest path distances of a metric closure that keeps every row in memory. The rows of
+ * the cities are looked up once, so a distance does not go through the cache of the closure.
+ */
+class ClosureDistance {
+public:
+    /**
+     * Constructor for the ClosureDistance class
+     * Complexity: O(n) if every row is cached, where n is the number of cities
+     * @param graph - the graph the cities belong to, with the metric closure mode on
+     * @param cities - the cities of the tour, must outlive the functor
+     */
+    ClosureDistance(Graph &graph, const vector<Vertex *> &cities) : graph(graph), cities(cities) {
+        for (Vertex *v: cities) {
+            rows.push_back(graph.getMetricClosure()->row(v->getId()));
+            ids.push_back(v->getId());
+        }
+    }
+
+    /**
+     * Gets the distance between two cities
+     * Complexity: O(1)
+     * @param a - index of the first city
+     * @param b - index of the second city
+     * @return the shortest path distance between the cities, or the same fallback as Graph::calculateTwoVerticesDist
+     * if they are not connected
+     */
+    double operator()(int a, int b) const {
+        Scalar dist = (*rows[a])[ids[b]];
+        return isinf(dist) ? graph.calculateTwoVerticesDist(cities[a], cities[b]) : dist;
+    }
+
+    /**
+     * Gets the number of cities
+     * @return the number of cities
+     */
+    int size() const {
+        return (int) cities.size();
+    }
+
+private:
+    Graph &graph; /**< Graph the cities belong to */
+    const vector<Vertex *> &cities; /**< Vertex of each city index */
+    vector<MetricClosure::Row> rows; /**< Shortest path distances from each city, indexed by vertex id */
+    vInt ids; /**< Vertex id of each city index */
+};
+
+#endif //PROJECT_TSP_TOURDISTANCE_H
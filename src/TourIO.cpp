@@ -0,0 +1,276 @@
+#include "TourIO.h"
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+/// Collects the output in a fixed size buffer and hands it to the stream in large writes.
+class BufferedWriter {
+public:
+    explicit BufferedWriter(ostream &out) : out(out) {}
+
+    ~BufferedWriter() {
+        flush();
+    }
+
+    void put(char c) {
+        if (used == sizeof(buffer)) flush();
+        buffer[used++] = c;
+    }
+
+    void put(const char *text) {
+        write(text, strlen(text));
+    }
+
+    void putInt(long long value) {
+        char digits[24];
+        write(digits, snprintf(digits, sizeof(digits), "%lld", value));
+    }
+
+    void putDouble(double value, int decimals) {
+        char digits[64];
+        int length = snprintf(digits, sizeof(digits), "%.*f", decimals, value);
+        write(digits, min<size_t>(length, sizeof(digits) - 1));
+    }
+
+    void putLittleEndian(uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++)
+            put((char) (value >> (8 * i) & 0xff));
+    }
+
+    void write(const char *data, size_t size) {
+        if (used + size > sizeof(buffer)) flush();
+        if (size > sizeof(buffer)) {
+            out.write(data, (streamsize) size);
+            return;
+        }
+        memcpy(buffer + used, data, size);
+        used += size;
+    }
+
+    void flush() {
+        out.write(buffer, (streamsize) used);
+        used = 0;
+    }
+
+private:
+    ostream &out; /**< Stream the buffer is written to */
+    char buffer[1 << 16]; /**< Output not yet written to the stream */
+    size_t used = 0; /**< Number of bytes of the buffer in use */
+};
+
+const char binaryMagic[4] = {'T', 'S', 'P', 'T'};
+const uint32_t binaryVersion = 1;
+
+uint64_t readLittleEndian(istream &in, int bytes) {
+    unsigned char data[8];
+    if (!in.read((char *) data, bytes)) throw invalid_argument("the tour file is truncated");
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--)
+        value = value << 8 | data[i];
+    return value;
+}
+
+/**
+ * Reads the array of integers that follows a key of a json document
+ * @param text - the json document
+ * @param key - the key, with its quotes
+ * @return the integers of the array
+ */
+vInt readJsonIds(const string &text, const string &key) {
+    size_t at = text.find(key);
+    if (at == string::npos) throw invalid_argument("the tour file has no " + key + " array");
+    at = text.find('[', at + key.size());
+    size_t end = text.find(']', at);
+    if (at == string::npos || end == string::npos) throw invalid_argument("the " + key + " array is not closed");
+
+    vInt ids;
+    const char *c = text.c_str() + at + 1, *stop = text.c_str() + end;
+    while (c < stop) {
+        char *after;
+        long id = strtol(c, &after, 10);
+        if (after == c) {
+            if (*c != ',' && !isspace((unsigned char) *c)) throw invalid_argument("the " + key + " array is malformed");
+            c++;
+            continue;
+        }
+        ids.push_back((int) id);
+        c = after;
+    }
+    return ids;
+}
+
+}
+
+bool TourIO::formatOf(const string &file_name, tour_format &format) {
+    size_t dot = file_name.find_last_of('.');
+    if (dot == string::npos) return false;
+    string extension = file_name.substr(dot + 1);
+    if (extension == "csv") format = csv;
+    else if (extension == "json") format = json;
+    else if (extension == "geojson") format = geojson;
+    else if (extension == "bin") format = binary;
+    else return false;
+    return true;
+}
+
+void TourIO::writeTour(ostream &out, const Graph &gh, const vInt &path, double distance, tour_format format) {
+    INSTRUMENT_SCOPE("writeTour");
+    BufferedWriter writer(out);
+    const vector<Vertex *> &vertexes = gh.getVertexSet();
+    switch (format) {
+        case csv:
+            writer.put("position,id,latitude,longitude\n");
+            for (size_t i = 0; i < path.size(); i++) {
+                writer.putInt((long long) i);
+                writer.put(',');
+                writer.putInt(gh.getOriginalId(path[i]));
+                writer.put(',');
+                writer.putDouble(vertexes[path[i]]->getLatitude(), 7);
+                writer.put(',');
+                writer.putDouble(vertexes[path[i]]->getLongitude(), 7);
+                writer.put('\n');
+            }
+            break;
+
+        case json:
+        case geojson:
+            writer.put(format == json ? "{\"distance\":" : "{\"type\":\"Feature\",\"properties\":{\"distance\":");
+            writer.putDouble(distance, 3);
+            writer.put(format == json ? ",\"tour\":[" : ",\"ids\":[");
+            for (size_t i = 0; i < path.size(); i++) {
+                if (i > 0) writer.put(',');
+                writer.putInt(gh.getOriginalId(path[i]));
+            }
+            if (format == json) {
+                writer.put("]}\n");
+                break;
+            }
+            writer.put("]},\"geometry\":{\"type\":\"LineString\",\"coordinates\":[");
+            for (size_t i = 0; i < path.size(); i++) {
+                writer.put(i > 0 ? ",[" : "[");
+                writer.putDouble(vertexes[path[i]]->getLongitude(), 7);
+                writer.put(',');
+                writer.putDouble(vertexes[path[i]]->getLatitude(), 7);
+                writer.put(']');
+            }
+            writer.put("]}}\n");
+            break;
+
+        case binary: {
+            uint64_t distanceBits;
+            memcpy(&distanceBits, &distance, sizeof(distance));
+            writer.write(binaryMagic, sizeof(binaryMagic));
+            writer.putLittleEndian(binaryVersion, 4);
+            writer.putLittleEndian(path.size(), 4);
+            writer.putLittleEndian(distanceBits, 8);
+            for (int v: path)
+                writer.putLittleEndian((uint32_t) gh.getOriginalId(v), 4);
+            break;
+        }
+    }
+}
+
+void TourIO::writeTourFile(const string &file_name, const Graph &gh, const vInt &path, double distance) {
+    tour_format format;
+    if (!formatOf(file_name, format)) throw invalid_argument("unknown tour format of " + file_name);
+    ofstream file(file_name, ios::binary);
+    if (!file) throw invalid_argument("cannot write " + file_name);
+    writeTour(file, gh, path, distance, format);
+    file.flush();
+    if (!file) throw invalid_argument("cannot write " + file_name);
+}
+
+double TourIO::readTour(istream &in, Graph &gh, vInt &path, tour_format format) {
+    INSTRUMENT_SCOPE("readTour");
+    vInt originalIds;
+    switch (format) {
+        case csv: {
+            string line;
+            getline(in, line);
+            while (getline(in, line)) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty()) continue;
+                istringstream iss(line);
+                string position, id;
+                getline(iss, position, ',');
+                getline(iss, id, ',');
+                try {
+                    originalIds.push_back(stoi(id));
+                } catch (exception &e) {
+                    throw invalid_argument("invalid line in the tour file: " + line);
+                }
+            }
+            break;
+        }
+
+        case json:
+        case geojson: {
+            stringstream text;
+            text << in.rdbuf();
+            originalIds = readJsonIds(text.str(), format == json ? "\"tour\"" : "\"ids\"");
+            break;
+        }
+
+        case binary: {
+            char magic[sizeof(binaryMagic)];
+            if (!in.read(magic, sizeof(magic)) || memcmp(magic, binaryMagic, sizeof(magic)) != 0)
+                throw invalid_argument("not a binary tour file");
+            if (readLittleEndian(in, 4) != binaryVersion) throw invalid_argument("unknown binary tour version");
+            uint64_t count = readLittleEndian(in, 4);
+            readLittleEndian(in, 8);
+            if (count > gh.getVertexSet().size() + 1) throw invalid_argument("the tour has too many stops");
+            originalIds.resize(count);
+            for (int &id: originalIds)
+                id = (int) (uint32_t) readLittleEndian(in, 4);
+            break;
+        }
+    }
+    return toPath(originalIds, gh, path);
+}
+
+double TourIO::readTourFile(const string &file_name, Graph &gh, vInt &path) {
+    tour_format format;
+    if (!formatOf(file_name, format)) throw invalid_argument("unknown tour format of " + file_name);
+    ifstream file(file_name, ios::binary);
+    if (!file) throw invalid_argument("cannot read " + file_name);
+    return readTour(file, gh, path, format);
+}
+
+double TourIO::toPath(const vInt &original_ids, Graph &gh, vInt &path) {
+    const vector<Vertex *> &vertexes = gh.getVertexSet();
+    size_t n = vertexes.size();
+    size_t stops = original_ids.size();
+    if (stops > 1 && original_ids.front() == original_ids.back()) stops--;
+    if (stops != n) {
+        throw invalid_argument("the tour has " + to_string(stops) + " vertexes, the graph has " + to_string(n));
+    }
+
+    vInt tour(n);
+    vector<bool> seen(n, false);
+    size_t start = 0;
+    for (size_t i = 0; i < n; i++) {
+        Vertex *v = gh.findVertexByOriginalId(original_ids[i]);
+        if (v == nullptr) throw invalid_argument("unknown vertex " + to_string(original_ids[i]));
+        if (seen[v->getId()]) throw invalid_argument("vertex " + to_string(original_ids[i]) + " is repeated");
+        seen[v->getId()] = true;
+        tour[i] = v->getId();
+        if (tour[i] == 0) start = i;
+    }
+
+    path.resize(n + 1);
+    for (size_t i = 0; i < n; i++)
+        path[i] = tour[(start + i) % n];
+    path[n] = path[0];
+
+    double distance = 0;
+    for (size_t i = 0; i < n; i++)
+        distance += gh.calculateTwoVerticesDist(vertexes[path[i]], vertexes[path[i + 1]]);
+    return distance;
+}
@@ -0,0 +1,103 @@
+#ifndef PROJECT_TSP_TOURIO_H
+#define PROJECT_TSP_TOURIO_H
+
+#include <iostream>
+#include <string>
+#include "Graph.h"
+
+using namespace std;
+
+/**
+ * Writes tours to files that other programs can read, and reads them back to start the local searches from them.
+ * Vertexes are written with the ids they have in the input files. The tour is streamed through a fixed size buffer, so
+ * exporting a large tour does not build the whole text in memory.
+ *
+ * Formats:
+ *   csv       position,id,latitude,longitude header, then one line per stop
+ *   json      {"distance":D,"tour":[V0,V1,...,V0]}
+ *   geojson   Feature with a LineString of [longitude,latitude] pairs, and the distance and ids in its properties
+ *   binary    "TSPT", version and number of stops as 32 bit integers, distance as a 64 bit double, then the ids as 32
+ *             bit integers, all little endian
+ * Only real graphs have coordinates, the vertexes of the other graphs are written at (0, 0).
+ */
+class TourIO {
+public:
+
+    /// Defines the file format of a tour.
+    enum tour_format {
+        csv,
+        json,
+        geojson,
+        binary
+    };
+
+    /**
+     * Gets the format of a tour file from its extension (.csv, .json, .geojson or .bin)
+     * Complexity: O(1)
+     * @param file_name - the name of the file
+     * @param format - set to the format of the file
+     * @return true if the extension is known, false otherwise
+     */
+    static bool formatOf(const string &file_name, tour_format &format);
+
+    /**
+     * Writes a tour to a stream
+     * Complexity: O(n) where n is the number of stops of the tour
+     * @param out - the stream the tour is written to, opened in binary mode for the binary format
+     * @param gh - the graph the tour belongs to
+     * @param path - the tour, with the current ids of the vertexes
+     * @param distance - the length of the tour
+     * @param format - the format of the output
+     */
+    static void writeTour(ostream &out, const Graph &gh, const vInt &path, double distance, tour_format format);
+
+    /**
+     * Writes a tour to a file, in the format given by its extension
+     * Complexity: O(n) where n is the number of stops of the tour
+     * @param file_name - the name of the file
+     * @param gh - the graph the tour belongs to
+     * @param path - the tour, with the current ids of the vertexes
+     * @param distance - the length of the tour
+     * @throws invalid_argument if the extension is unknown or the file cannot be written
+     */
+    static void writeTourFile(const string &file_name, const Graph &gh, const vInt &path, double distance);
+
+    /**
+     * Reads a tour written by writeTour. The tour may start at any vertex and may leave out the return to its first
+     * vertex, it is rotated to start and end at vertex 0. The distance stored in the file is ignored and computed
+     * again, since it depends on how the graph measures missing edges
+     * Complexity: O(n) plus n distance computations, where n is the number of vertexes
+     * @param in - the stream the tour is read from
+     * @param gh - the graph the tour belongs to
+     * @param path - filled with the tour, with the current ids of the vertexes
+     * @param format - the format of the input
+     * @return the length of the tour
+     * @throws invalid_argument if the input is malformed or is not a tour through every vertex of the graph
+     */
+    static double readTour(istream &in, Graph &gh, vInt &path, tour_format format);
+
+    /**
+     * Reads a tour from a file, in the format given by its extension
+     * Complexity: the same as readTour
+     * @param file_name - the name of the file
+     * @param gh - the graph the tour belongs to
+     * @param path - filled with the tour, with the current ids of the vertexes
+     * @return the length of the tour
+     * @throws invalid_argument if the extension is unknown, the file cannot be read or readTour fails
+     */
+    static double readTourFile(const string &file_name, Graph &gh, vInt &path);
+
+private:
+
+    /**
+     * Turns the ids of a tour in the input files into a tour over every vertex that starts and ends at vertex 0
+     * Complexity: O(n) plus n distance computations, where n is the number of vertexes
+     * @param original_ids - the stops of the tour, with the ids of the input files
+     * @param gh - the graph the tour belongs to
+     * @param path - filled with the tour, with the current ids of the vertexes
+     * @return the length of the tour
+     */
+    static double toPath(const vInt &original_ids, Graph &gh, vInt &path);
+};
+
+#endif //PROJECT_TSP_TOURIO_H
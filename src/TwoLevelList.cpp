@@ -0,0 +1,107 @@
+#include "TwoLevelList.h"
+#include <algorithm>
+#include <cmath>
+
+TwoLevelList::TwoLevelList(const vector<int> &tour) {
+    assign(tour);
+}
+
+void TwoLevelList::assign(const vector<int> &tour) {
+    cities = tour;
+    int n = (int) cities.size();
+    int maxCity = -1;
+    for (int city: cities) maxCity = max(maxCity, city);
+    position.assign(maxCity + 1, 0);
+    segmentOf.assign(maxCity + 1, 0);
+
+    segmentSize = max(8, (int) sqrt((double) n));
+    segments.clear();
+    order.clear();
+    for (int begin = 0; begin < n; begin += segmentSize) {
+        Segment s;
+        s.begin = begin;
+        s.end = min(n, begin + segmentSize);
+        s.rank = (int) order.size();
+        for (int i = s.begin; i < s.end; i++) {
+            position[cities[i]] = i;
+            segmentOf[cities[i]] = (int) segments.size();
+        }
+        order.push_back((int) segments.size());
+        segments.push_back(s);
+    }
+}
+
+void TwoLevelList::flip(int from, int to) {
+    if (from == to) return;
+    splitBefore(from);
+    int after = next(to);
+    if (after != from) splitBefore(after);
+
+    // from..to is now made of whole segments, reverse their order and each one of them
+    int m = (int) order.size();
+    int start = segments[segmentOf[from]].rank;
+    int i = start, j = segments[segmentOf[to]].rank;
+    int count = j - i;
+    if (count < 0) count += m;
+    count++;
+    for (int swaps = count / 2; swaps > 0; swaps--) {
+        swap(order[i], order[j]);
+        if (++i == m) i = 0;
+        if (--j < 0) j = m - 1;
+    }
+    for (int k = 0, r = start; k < count; k++) {
+        Segment &s = segments[order[r]];
+        s.reversed = !s.reversed;
+        s.rank = r;
+        if (++r == m) r = 0;
+    }
+
+    // Every flip adds up to two segments, lay the cities out again once there are too many
+    if (order.size() > 2 * (cities.size() / segmentSize + 1)) rebuild();
+}
+
+void TwoLevelList::copyTo(vector<int> &tour, int start) const {
+    tour.resize(cities.size());
+    int city = start;
+    for (int &c: tour) {
+        c = city;
+        city = next(city);
+    }
+}
+
+void TwoLevelList::splitBefore(int city) {
+    int id = segmentOf[city];
+    Segment s = segments[id];
+    if (first(s) == city) return;
+
+    // low = [begin, cut) and high = [cut, end), high comes later in the tour unless the segment is reversed
+    int cut = s.reversed ? position[city] + 1 : position[city];
+    bool moveHigh = s.end - cut <= cut - s.begin;
+    Segment part;
+    part.reversed = s.reversed;
+    if (moveHigh) {
+        part.begin = cut;
+        part.end = s.end;
+        segments[id].end = cut;
+    } else {
+        part.begin = s.begin;
+        part.end = cut;
+        segments[id].begin = cut;
+    }
+
+    int partId = (int) segments.size();
+    for (int i = part.begin; i < part.end; i++)
+        segmentOf[cities[i]] = partId;
+    segments.push_back(part);
+
+    int rank = moveHigh != s.reversed ? s.rank + 1 : s.rank;
+    order.insert(order.begin() + rank, partId);
+    for (int r = rank; r < (int) order.size(); r++)
+        segments[order[r]].rank = r;
+}
+
+void TwoLevelList::rebuild() {
+    vector<int> tour;
+    copyTo(tour, first(segments[order[0]]));
+    assign(tour);
+}
@@ -0,0 +1,148 @@
+#ifndef PROJECT_TSP_TWOLEVELLIST_H
+#define PROJECT_TSP_TWOLEVELLIST_H
+
+#include <vector>
+
+using namespace std;
+
+/**
+ * Tour representation where reversing a path does not cost time proportional to its length. The cities are split into
+ * about sqrt(n) segments, each one a range of an array of cities with a reversal bit, and the segments are kept in
+ * tour order. Reversing a path splits at most two segments at its endpoints, then reverses the order of the segments
+ * in between and toggles their reversal bits, without moving any city.
+ * The cities must be distinct non negative integers, usually the indices 0..n-1.
+ */
+class TwoLevelList {
+public:
+    /**
+     * Constructor for an empty TwoLevelList
+     */
+    TwoLevelList() = default;
+
+    /**
+     * Constructor for the TwoLevelList class
+     * @param tour - the cities in tour order
+     */
+    explicit TwoLevelList(const vector<int> &tour);
+
+    /**
+     * Replaces the tour
+     * Complexity: O(n) where n is the number of cities
+     * @param tour - the cities in tour order
+     */
+    void assign(const vector<int> &tour);
+
+    /**
+     * Gets the number of cities in the tour
+     * @return the number of cities
+     */
+    int size() const { return (int) cities.size(); }
+
+    /**
+     * Gets the city that follows a city in the tour
+     * Complexity: O(1)
+     * @param city - the city
+     * @return the next city
+     */
+    int next(int city) const {
+        const Segment &s = segments[segmentOf[city]];
+        int i = position[city];
+        if (!s.reversed) {
+            if (i + 1 < s.end) return cities[i + 1];
+        } else if (i > s.begin) return cities[i - 1];
+        return first(segments[order[s.rank + 1 == (int) order.size() ? 0 : s.rank + 1]]);
+    }
+
+    /**
+     * Gets the city that precedes a city in the tour
+     * Complexity: O(1)
+     * @param city - the city
+     * @return the previous city
+     */
+    int prev(int city) const {
+        const Segment &s = segments[segmentOf[city]];
+        int i = position[city];
+        if (!s.reversed) {
+            if (i > s.begin) return cities[i - 1];
+        } else if (i + 1 < s.end) return cities[i + 1];
+        return last(segments[order[s.rank == 0 ? (int) order.size() - 1 : s.rank - 1]]);
+    }
+
+    /**
+     * Checks if b is on the path that goes forward from a to c, endpoints included
+     * Complexity: O(1)
+     * @param a - first city of the path
+     * @param b - the city to be checked
+     * @param c - last city of the path
+     * @return true if b is between a and c, false otherwise
+     */
+    bool between(int a, int b, int c) const {
+        long long ka = key(a), kb = key(b), kc = key(c);
+        if (ka <= kc) return ka <= kb && kb <= kc;
+        return kb >= ka || kb <= kc;
+    }
+
+    /**
+     * Reverses the path that goes forward from one city to another, replacing the edges (prev(from), from) and
+     * (to, next(to)) by (prev(from), to) and (from, next(to)). The rest of the tour keeps its direction
+     * Complexity: O(sqrt(n)) amortized, where n is the number of cities
+     * @param from - first city of the path
+     * @param to - last city of the path
+     */
+    void flip(int from, int to);
+
+    /**
+     * Writes the cities in tour order
+     * Complexity: O(n) where n is the number of cities
+     * @param tour - filled with the cities
+     * @param start - the city written first
+     */
+    void copyTo(vector<int> &tour, int start) const;
+
+private:
+    /// Range [begin, end) of the cities array, read backwards when reversed is set.
+    struct Segment {
+        int begin = 0; /**< Index of the first city of the range */
+        int end = 0; /**< Index past the last city of the range */
+        bool reversed = false; /**< True if the segment is traversed from end - 1 down to begin */
+        int rank = 0; /**< Position of the segment in order */
+    };
+
+    vector<int> cities; /**< Every city, each segment is a range of this array */
+    vector<int> position; /**< Index of each city in cities */
+    vector<int> segmentOf; /**< Segment of each city */
+    vector<Segment> segments; /**< Segments, including the ones split since the last rebuild */
+    vector<int> order; /**< Segments in tour order */
+    int segmentSize = 1; /**< Number of cities per segment after a rebuild */
+
+    int first(const Segment &s) const { return s.reversed ? cities[s.end - 1] : cities[s.begin]; }
+
+    int last(const Segment &s) const { return s.reversed ? cities[s.begin] : cities[s.end - 1]; }
+
+    /**
+     * Gets a number that increases along the tour, starting from the first segment of order
+     * @param city - the city
+     * @return the key of the city
+     */
+    long long key(int city) const {
+        const Segment &s = segments[segmentOf[city]];
+        int offset = s.reversed ? s.end - 1 - position[city] : position[city] - s.begin;
+        return (long long) s.rank * (long long) (cities.size() + 1) + offset;
+    }
+
+    /**
+     * Splits the segment of a city, if needed, so that the city is the first one of its segment. The smaller part
+     * becomes a new segment
+     * Complexity: O(sqrt(n)) where n is the number of cities
+     * @param city - the city
+     */
+    void splitBefore(int city);
+
+    /**
+     * Lays the cities out again in tour order, in segments of equal size
+     * Complexity: O(n) where n is the number of cities
+     */
+    void rebuild();
+};
+
+#endif //PROJECT_TSP_TWOLEVELLIST_H
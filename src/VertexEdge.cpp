@@ -5,7 +5,7 @@ using namespace std;
 /************************* Vertex  **************************/
 
 Vertex::Vertex(int id, double longitude, double latitude)
-        : id(id), latitude(latitude), longitude(longitude) {}
+        : id(id), latitude((Scalar) latitude), longitude((Scalar) longitude) {}
 
 Vertex::Vertex(int id) : id(id) {
     this->latitude = 0;
@@ -15,28 +15,61 @@ Vertex::Vertex(int id) : id(id) {
 int Vertex::getId() const {
     return this->id;
 }
-/*
- * Auxiliary function to add an outgoing edge to a vertex (this),
- * with a given destination vertex (d) and edge weight (w).
- */
-Edge * Vertex::addEdge(Vertex *d, double w) {
-    auto newEdge = new Edge(this, d, w);
-    adj.push_back(newEdge);
-    d->incoming.push_back(newEdge);
-    return newEdge;
-}
-
-void Vertex::removeOutgoingEdges() {
-    auto it = adj.begin();
-    while (it != adj.end()) {
-        Edge *edge = *it;
-        it = adj.erase(it);
-        deleteEdge(edge);
+
+void Vertex::setId(int id) {
+    this->id = id;
+}
+
+namespace {
+    const unsigned minIndexedEdges = 8; /**< Vertexes with fewer edges than this are not indexed */
+
+    /**
+     * Computes the first slot probed for a destination id (Fibonacci hashing)
+     * @param id - id of the destination vertex
+     * @param shift - 32 minus the base-2 logarithm of the table size
+     * @return the slot of the id in the table
+     */
+    inline unsigned edgeSlot(int id, unsigned shift) {
+        return ((unsigned) id * 2654435769u) >> shift;
     }
 }
 
+void Vertex::buildEdgeIndex() {
+    edgeIndex.clear();
+    if (adj.size() < minIndexedEdges) return;
+
+    // At most half of the slots are used, so the probe sequences stay short
+    unsigned bits = 1;
+    while ((1u << bits) < 2 * adj.size()) bits++;
+    edgeIndexShift = 32 - bits;
+    edgeIndex.assign(1u << bits, {-1, -1});
+
+    unsigned mask = (1u << bits) - 1;
+    for (int i = 0; i < (int) adj.size(); i++) {
+        int dest = adj[i]->getOther(this)->getId();
+        unsigned slot = edgeSlot(dest, edgeIndexShift);
+        while (edgeIndex[slot].first != -1 && edgeIndex[slot].first != dest)
+            slot = (slot + 1) & mask;
+        // Like the linear scan, the first edge towards a destination wins
+        if (edgeIndex[slot].first == -1) edgeIndex[slot] = {dest, i};
+    }
+}
 
-std::vector<Edge*> Vertex::getAdj() const {
+void Vertex::sortAdjByDest() {
+    edgeIndex.clear();
+    // Stable, so parallel edges keep the order they were read in with every standard library
+    stable_sort(adj.begin(), adj.end(), [this](Edge *e1, Edge *e2) {
+        return e1->getOther(this)->getId() < e2->getOther(this)->getId();
+    });
+}
+
+void Vertex::addEdge(Edge *edge) {
+    adj.push_back(edge);
+    edgeIndex.clear();
+}
+
+
+const std::vector<Edge*> &Vertex::getAdj() const {
     return this->adj;
 }
 
@@ -48,21 +81,6 @@ void Vertex::setPath(Edge *path) {
     this->path = path;
 }
 
-void Vertex::deleteEdge(Edge *edge) {
-    Vertex *dest = edge->getDest();
-    // Remove the corresponding edge from the incoming list
-    auto it = dest->incoming.begin();
-    while (it != dest->incoming.end()) {
-        if ((*it)->getOrig()->getId() == id) {
-            it = dest->incoming.erase(it);
-        }
-        else {
-            it++;
-        }
-    }
-    delete edge;
-}
-
 double Vertex::getPrimDist() const {
     return this->primDist;
 }
@@ -92,8 +110,18 @@ double Vertex::getLongitude() const {
 }
 
 Edge *Vertex::findEdge(int dest) {
+    INSTRUMENT_COUNT(findEdgeCalls);
+    if (!edgeIndex.empty()) {
+        unsigned mask = edgeIndex.size() - 1;
+        for (unsigned slot = edgeSlot(dest, edgeIndexShift); edgeIndex[slot].first != -1; slot = (slot + 1) & mask) {
+            if (edgeIndex[slot].first == dest)
+                return adj[edgeIndex[slot].second];
+        }
+        return nullptr;
+    }
+
     for (Edge *e: this->adj) {
-        if (e->getDest()->getId() == dest)
+        if (e->getOther(this)->getId() == dest)
             return e;
     }
 
@@ -111,7 +139,7 @@ void Vertex::setOutdegree(int outdegree) {
 /********************** Edge  ****************************/
 
 
-Edge::Edge(Vertex *orig, Vertex *dest, double distance): orig(orig), dest(dest), distance(distance) {}
+Edge::Edge(Vertex *orig, Vertex *dest, double distance): orig(orig), dest(dest), distance((Scalar) distance) {}
 
 Vertex * Edge::getDest() const {
     return this->dest;
@@ -125,15 +153,6 @@ Vertex * Edge::getOrig() const {
     return this->orig;
 }
 
-Edge *Edge::getReverse() const {
-    return this->reverse;
-}
-
-
-void Edge::setReverse(Edge *reverse) {
-    this->reverse = reverse;
-}
-
 bool Edge::getSelected() const {
     return this->selected;
 }
@@ -146,6 +165,10 @@ void Edge::setIsDouble(bool isDouble) {
     this->isDouble = isDouble;
 }
 
+void Edge::setDistance(double distance) {
+    this->distance = (Scalar) distance;
+}
+
 bool Edge::getIsDouble() const {
     return this->isDouble;
 }
@@ -8,9 +8,16 @@
 #include <limits>
 #include <algorithm>
 #include "MutablePriorityQueue.h"
+#include "Instrumentation.h"
 
 using namespace std;
 
+#ifdef TSP_FLOAT_WEIGHTS
+typedef float Scalar; /**< Type the edge lengths and coordinates are stored as, float halves their size */
+#else
+typedef double Scalar; /**< Type the edge lengths and coordinates are stored as */
+#endif
+
 class Edge;
 /************************* Vertex  **************************/
 
@@ -33,17 +40,47 @@ public:
      */
     Vertex(int id, double longitude, double latitude);
 
+    /// Vertexes are owned by their graph and referenced by their edges, so they cannot be copied.
+    Vertex(const Vertex &) = delete;
+
+    Vertex &operator=(const Vertex &) = delete;
+
     /**
      * Gets the id attribute of the vertex
      * @return the id of the vertex
      */
     int getId() const;
 
+    /**
+     * Sets the id attribute of the vertex. Used by the graph when it renumbers its vertexes, after which the edge
+     * indexes of the neighbours must be built again
+     * @param id - the new id of the vertex
+     */
+    void setId(int id);
+
+    /**
+     * Builds an open-addressing hash table over the adjacency vector, keyed by the id of the other endpoint, so
+     * that findEdge does not have to scan every edge. Vertexes with few edges keep the linear scan, which is faster for
+     * them. The table has between 2 and 4 slots of 8 bytes per edge. Adding or sorting edges drops the table, until
+     * it is built again
+     * Complexity: O(E) where E is the number of outgoing edges of the vertex
+     */
+    void buildEdgeIndex();
+
+    /**
+     * Sorts the adjacency vector by the id of the other endpoint, so that edges towards vertexes with close ids
+     * are stored close to each other
+     * Complexity: O(E*log(E)) where E is the number of outgoing edges of the vertex
+     */
+    void sortAdjByDest();
+
     /**
      * Gets the adj attribute from the vertex
-     * @return a vector containing all the adjacent edges of the vertex
+     * Complexity: O(1)
+     * @return a reference to the vector containing all the edges of the vertex, shared with the other endpoint of each
+     * one of them
      */
-    vector<Edge *> getAdj() const;
+    const vector<Edge *> &getAdj() const;
 
     /**
      * Gets the path attribute of the vertex
@@ -64,18 +101,12 @@ public:
     void setVisited(bool visited);
 
     /**
-     * Adds an edge from the vertex (this) to the destination vertex, with a given weight
-     * @param dest - the destination vertex
-     * @param w - the weight of the edge
-     * @return the edge created
-     */
-    Edge * addEdge(Vertex *dest, double w);
-
-    /**
-     * Removes all the outgoing edges of the vertex from the adjacency vector
-     * Time Complexity: O(E²), where E is the number of edges
+     * Adds an edge to the adjacency vector of the vertex (this), which must be one of its endpoints. The edge is owned
+     * by the graph
+     * Complexity: O(1) amortized
+     * @param edge - the edge
      */
-    void removeOutgoingEdges();
+    void addEdge(Edge *edge);
 
     /**
      * Gets the primDist value of the vertex
@@ -115,9 +146,10 @@ public:
     double getLongitude() const;
 
     /**
-     * Finds an edge that connects the current vertex (this) to the destination vertex
-     * Ccomplexity: O(E) where E is the number of edges in the graph
-     * @param dest id of the destination vertex
+     * Finds an edge that connects the current vertex (this) to another vertex
+     * Complexity: O(1) on average if the edge index was built, O(E) otherwise, where E is the number of edges of the
+     * vertex
+     * @param dest id of the other vertex
      * @return a pointer to the selected edge or nullptr if there is no edge connecting the current vertex to dest
      */
     Edge * findEdge(int dest);
@@ -138,47 +170,55 @@ protected:
     int id; /**< The id of the vertex */
     vector<Edge *> adj; /**< The adjacency vector of the vertex */
     Edge *path = nullptr; /**< Edge path of the vertex */
-    double latitude; /**< Latitude of the vertex */
-    double longitude; /**< Longitude of the vertex */
+    Scalar latitude; /**< Latitude of the vertex */
+    Scalar longitude; /**< Longitude of the vertex */
     int outdegree /**< Number of outgoing edges **/;
+    vector<pair<int, int>> edgeIndex; /**< Hash table of (other endpoint id, index in adj), id -1 for empty slots */
+    unsigned edgeIndexShift = 0; /**< Shift that turns a hashed id into a slot of edgeIndex */
 
 protected:
     double primDist; /**< Auxiliary distance to be used to run Prim's algorithm */
     bool visited = false; /**< Boolean to check if the vertex has been visited */
-    vector<Edge *> incoming; /**< Vector of incoming edges of the vertex */
-
-    /**
-     * Removes an edge from both its origin and destination vertices
-     * Complexity: O(E) where E is the number of edges of the graph
-     * @param edge - the edge to be removed
-     */
-    void deleteEdge(Edge *edge);
 };
 
 /********************** Edge  ****************************/
 
+/**
+ * Undirected edge, stored once by the graph and shared by the adjacency vectors of its two endpoints, so its flags are
+ * written once for both directions.
+ */
 class Edge {
 public:
     /**
-     * Constructs an edge with a given origin, destination and length
-     * @param orig - the origin vertex of the edge
-     * @param dest - the destination vertex of the edge
+     * Constructs an edge with given endpoints and length
+     * @param orig - the first endpoint of the edge
+     * @param dest - the second endpoint of the edge
      * @param distance - the length of the edge
      */
     Edge(Vertex *orig, Vertex *dest, double distance);
 
     /**
      * Gets the dest attribute of the edge
-     * @return the destination vertex of the edge
+     * @return the second endpoint of the edge
      */
     Vertex * getDest() const;
 
     /**
      * Gets the orig attribute of the edge
-     * @return the origin vertex of the edge
+     * @return the first endpoint of the edge
      */
     Vertex * getOrig() const;
 
+    /**
+     * Gets the endpoint of the edge that is not a given vertex
+     * Complexity: O(1)
+     * @param v - one of the endpoints of the edge
+     * @return the other endpoint
+     */
+    Vertex * getOther(const Vertex *v) const {
+        return v == orig ? dest : orig;
+    }
+
     /**
      * Gets the distance attribute of the edge
      * @return the distance between the two vertexes the edge connects
@@ -197,18 +237,6 @@ public:
      */
     bool getIsDouble() const;
 
-    /**
-     * Gets the reverse attribute of the edge
-     * @return the reverse edge of the edge
-     */
-    Edge *getReverse() const;
-
-    /**
-     * Sets the reverse attribute of the edge
-     * @param reverse - the reverse edge of the edge
-     */
-    void setReverse(Edge *reverse);
-
     /**
      * Sets the selected attribute of the edge
      * @param selected whether the vertex is selected for the eulerian tour
@@ -221,14 +249,19 @@ public:
      */
     void setIsDouble(bool isDouble);
 
+    /**
+     * Sets the distance attribute of the edge
+     * @param distance the new length of the edge
+     */
+    void setDistance(double distance);
+
 
 protected:
-    Vertex * dest; /**< Destination vertex of the edge */
-    Vertex *orig; /**< Origin vertex of the edge */
-    Edge *reverse = nullptr; /**< Reverse edge of the edge */
-    double distance; /**< Length of the edge */
-    bool selected; /**< Edge selected to find eulerian path */
-    bool isDouble; /**< True if this edge represents two edges between the two vertexes in the eulerian tour */
+    Vertex * dest; /**< Second endpoint of the edge */
+    Vertex *orig; /**< First endpoint of the edge */
+    Scalar distance; /**< Length of the edge */
+    bool selected = false; /**< Edge selected to find eulerian path */
+    bool isDouble = false; /**< True if this edge represents two edges between the two vertexes in the eulerian tour */
 };
 
 #endif /* DA_TP_CLASSES_VERTEX_EDGE */
\ No newline at end of file